@@ -0,0 +1,89 @@
+#!/bin/sh
+# netns_rig.sh
+# Banco de dos "hosts" en una sola máquina: dos network namespaces unidos por
+# un par veth, con netem opcional en ambos extremos. Así cliente y servidor
+# pasan por ruteo, qdisc y offloads reales en vez de por loopback.
+#
+#   sudo ./netns_rig.sh up ['delay 10ms loss 1%']   crear (y aplicar netem)
+#   sudo ./netns_rig.sh netem 'delay 25ms 5ms'       cambiar el impairment
+#   sudo ./netns_rig.sh netem none                   sacarlo
+#   sudo ./netns_rig.sh srv ../ej2/tcp_server        correr en el "servidor"
+#   sudo ./netns_rig.sh cli ../ej2/tcp_client 10.77.0.1 -d 10 -N 5
+#   sudo ./netns_rig.sh bench [args]                 transport_bench en el banco
+#   sudo ./netns_rig.sh status | down
+#
+# Los nombres y direcciones se pueden cambiar con RIG_SRV, RIG_CLI, RIG_IF y
+# RIG_NET (los tres primeros octetos).
+set -e
+
+SRV=${RIG_SRV:-owd_srv}
+CLI=${RIG_CLI:-owd_cli}
+IF=${RIG_IF:-owd0}         # mismo nombre de interfaz en los dos namespaces
+NET=${RIG_NET:-10.77.0}
+SRV_IP=$NET.1
+CLI_IP=$NET.2
+
+usage() {
+    sed -n '2,17p' "$0" | sed 's/^# \{0,1\}//'
+    exit 1
+}
+
+set_netem() {
+    for ns in "$SRV" "$CLI"; do
+        if [ "$1" = "none" ] || [ -z "$1" ]; then
+            ip netns exec "$ns" tc qdisc del dev "$IF" root 2>/dev/null || true
+        else
+            # shellcheck disable=SC2086  # los argumentos de netem van separados
+            ip netns exec "$ns" tc qdisc replace dev "$IF" root netem $1
+        fi
+    done
+}
+
+rig_up() {
+    ip netns add "$SRV"
+    ip netns add "$CLI"
+    ip link add rig-srv type veth peer name rig-cli
+    ip link set rig-srv netns "$SRV"
+    ip link set rig-cli netns "$CLI"
+    ip -n "$SRV" link set rig-srv name "$IF"
+    ip -n "$CLI" link set rig-cli name "$IF"
+    ip -n "$SRV" addr add "$SRV_IP/24" dev "$IF"
+    ip -n "$CLI" addr add "$CLI_IP/24" dev "$IF"
+    for ns in "$SRV" "$CLI"; do
+        ip -n "$ns" link set lo up
+        ip -n "$ns" link set "$IF" up
+    done
+    [ -n "$1" ] && set_netem "$1"
+    echo "Banco listo: $SRV ($SRV_IP) <-> $CLI ($CLI_IP) por $IF"
+}
+
+rig_down() {
+    # borrar un namespace borra su extremo del veth y con él el par
+    ip netns del "$SRV" 2>/dev/null || true
+    ip netns del "$CLI" 2>/dev/null || true
+}
+
+rig_status() {
+    for ns in "$SRV" "$CLI"; do
+        echo "== $ns"
+        ip -n "$ns" -br addr show dev "$IF"
+        ip netns exec "$ns" tc qdisc show dev "$IF"
+    done
+}
+
+[ $# -ge 1 ] || usage
+cmd=$1
+shift
+
+case "$cmd" in
+    up)     rig_up "$1" ;;
+    down)   rig_down ;;
+    netem)  [ $# -ge 1 ] || usage; set_netem "$1" ;;
+    status) rig_status ;;
+    srv)    exec ip netns exec "$SRV" "$@" ;;
+    cli)    exec ip netns exec "$CLI" "$@" ;;
+    bench)
+        # cada perfil de transport_bench se aplica con netem en ambos extremos
+        exec ./transport_bench -n "$SRV,$CLI" -H "$SRV_IP" -I "$IF" "$@" ;;
+    *)      usage ;;
+esac
@@ -0,0 +1,525 @@
+// transport_bench.c
+// Compara la transferencia de los mismos archivos con el protocolo de ej1
+// (UDP stop & wait) y con un flujo TCP de ej2 (tcp_client -F -> tcp_server -B)
+// bajo distintos perfiles de red (netem), y arma un único reporte con tiempo
+// de transferencia, goodput y CPU por byte. Con perf_event_open se cuentan
+// además ciclos, instrucciones, fallos de caché y cambios de contexto de
+// cliente y servidor, para comparar eficiencia y no sólo tiempo.
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#define MAX_FILES     16
+#define MAX_PROFILES  16
+#define MAX_REPS      64
+#define EJ1_REMOTE    "bench.dat"     // nombre remoto (ej1 pide 4-10 caracteres)
+#define EJ1_CRED      "g21-0e29"
+
+typedef struct {
+    const char *name;
+    const char *netem;   // argumentos de `tc qdisc ... netem` ("" = sin impairment)
+} profile_t;
+
+// Perfiles por defecto, a tono con los escenarios capturados en ej1/src/*.pcap
+static profile_t profiles[MAX_PROFILES] = {
+    { "none",  "" },
+    { "lan",   "delay 1ms 200us" },
+    { "inter", "delay 25ms 5ms loss 0.5%" },
+    { "lossy", "delay 10ms loss 5%" },
+};
+static int n_profiles = 4;
+
+typedef struct {
+    const char *ej1_dir, *ej2_dir;   // donde están los binarios de cada ejercicio
+    const char *host;                // IP de los servidores vista por los clientes
+    const char *iface;               // interfaz donde se aplica netem
+    const char *workdir;             // directorio temporal de los servidores
+    int reps, timeout_s;
+    // -n: servidores y clientes en dos network namespaces (netns_rig.sh), con
+    // netem aplicado a la interfaz -I de cada uno
+    char srv_ns[64], cli_ns[64];
+} bench_opts_t;
+
+// Contadores por proceso (con sus hilos): se abren sobre el hijo antes del
+// exec y arrancan con él (enable_on_exec)
+enum { PC_CYCLES, PC_INSTR, PC_CACHE_MISS, PC_CTXSW, PC_COUNT };
+
+static const struct { uint32_t type; uint64_t config; const char *name; } perf_events[PC_COUNT] = {
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES,       "cycles" },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS,     "instructions" },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES,     "cache_misses" },
+    { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES, "context_switches" },
+};
+
+typedef struct {
+    int fd[PC_COUNT];   // -1 => el evento no está disponible
+} perf_set_t;
+
+typedef struct {
+    int      ok;
+    double   wall_ms;
+    double   cpu_client_us, cpu_server_us;
+    double   perf[PC_COUNT];   // cliente + servidor; < 0 => sin dato
+    uint64_t bytes;
+} run_result_t;
+
+static int perf_warned[PC_COUNT];
+
+static uint64_t now_us(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (uint64_t)tv.tv_sec * 1000000ULL + (uint64_t)tv.tv_usec;
+}
+
+static double rusage_us(const struct rusage *ru) {
+    return (double)(ru->ru_utime.tv_sec + ru->ru_stime.tv_sec) * 1e6 +
+           (double)(ru->ru_utime.tv_usec + ru->ru_stime.tv_usec);
+}
+
+static void perf_open(perf_set_t *ps, pid_t pid) {
+    for (int i = 0; i < PC_COUNT; i++) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = perf_events[i].type;
+        attr.config = perf_events[i].config;
+        attr.disabled = 1;
+        attr.enable_on_exec = 1;
+        attr.inherit = 1;   // hilos (escritor de qlog, vigilante de disco, etc.)
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        ps->fd[i] = (int)syscall(SYS_perf_event_open, &attr, pid, -1, -1, PERF_FLAG_FD_CLOEXEC);
+        if (ps->fd[i] < 0 && !perf_warned[i]) {
+            perf_warned[i] = 1;
+            fprintf(stderr, "perf_event_open(%s): %s; la columna queda vacía\n",
+                    perf_events[i].name, strerror(errno));
+        }
+    }
+}
+
+// Lee (escalando si hubo multiplexado) y cierra; -1 donde no hay dato
+static void perf_collect(perf_set_t *ps, double out[PC_COUNT]) {
+    for (int i = 0; i < PC_COUNT; i++) {
+        uint64_t v[3];   // valor, tiempo habilitado, tiempo corriendo
+        out[i] = -1;
+        if (ps->fd[i] < 0) continue;
+        if (read(ps->fd[i], v, sizeof(v)) == (ssize_t)sizeof(v)) {
+            out[i] = v[2] > 0 ? (double)v[0] * (double)v[1] / (double)v[2] : (double)v[0];
+        }
+        close(ps->fd[i]);
+        ps->fd[i] = -1;
+    }
+}
+
+// fork + exec con cwd y stdout/stderr redirigidos a out (NULL => /dev/null),
+// dentro del namespace netns si no es vacío (`ip netns exec` hace exec del
+// comando, así que el pid sigue siendo el del programa). Con ps, el hijo
+// espera a que se abran los contadores antes del exec.
+static pid_t spawn(char *const argv[], const char *cwd, const char *out, const char *netns,
+                   perf_set_t *ps) {
+    int gate[2];
+    if (pipe2(gate, O_CLOEXEC) < 0) {
+        perror("pipe");
+        return -1;
+    }
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        close(gate[0]);
+        close(gate[1]);
+        return -1;
+    }
+    if (pid == 0) {
+        char c;
+        close(gate[1]);
+        while (read(gate[0], &c, 1) < 0 && errno == EINTR) {
+        }
+        int fd = open(out ? out : "/dev/null", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd >= 0) {
+            dup2(fd, STDOUT_FILENO);
+            dup2(fd, STDERR_FILENO);
+            close(fd);
+        }
+        if (cwd && chdir(cwd) < 0) _exit(127);
+        if (netns[0]) {
+            char *nsargv[16] = { "ip", "netns", "exec", (char *)netns };
+            for (int i = 0; argv[i] && i < 11; i++) nsargv[4 + i] = argv[i];
+            execvp("ip", nsargv);
+        } else {
+            execv(argv[0], argv);
+        }
+        _exit(127);
+    }
+    close(gate[0]);
+    if (ps) perf_open(ps, pid);
+    close(gate[1]);   // EOF: el hijo sigue con el exec
+    return pid;
+}
+
+// Espera a pid como mucho timeout_ms (lo mata al vencer). Devuelve el estado
+// de wait4 o -1, y deja en ru el uso de CPU del proceso.
+static int wait_for(pid_t pid, int timeout_ms, struct rusage *ru) {
+    int status;
+    uint64_t deadline = now_us() + (uint64_t)timeout_ms * 1000ULL;
+    while (1) {
+        pid_t r = wait4(pid, &status, WNOHANG, ru);
+        if (r == pid) return status;
+        if (r < 0) return -1;
+        if (now_us() >= deadline) {
+            kill(pid, SIGKILL);
+            wait4(pid, &status, 0, ru);
+            return -1;
+        }
+        usleep(1000);
+    }
+}
+
+// Corre `tc` (en ambos namespaces con -n) y devuelve 0 si salió bien
+static int run_tc(const char *verb, const bench_opts_t *o, const char *netem) {
+    const char *ns[2] = { o->srv_ns, o->cli_ns };
+    int ret = 0;
+    for (int i = 0; i < (o->srv_ns[0] ? 2 : 1); i++) {
+        char cmd[512], prefix[96] = "";
+        if (o->srv_ns[0]) snprintf(prefix, sizeof(prefix), "ip netns exec %s ", ns[i]);
+        snprintf(cmd, sizeof(cmd), "%stc qdisc %s dev %s root%s%s >/dev/null 2>&1", prefix,
+                 verb, o->iface, netem ? " netem " : "", netem ? netem : "");
+        if (system(cmd) != 0) ret = -1;
+    }
+    return ret;
+}
+
+static int same_file(const char *a, const char *b) {
+    FILE *fa = fopen(a, "rb"), *fb = fopen(b, "rb");
+    int same = fa && fb;
+    while (same) {
+        int ca = fgetc(fa), cb = fgetc(fb);
+        if (ca != cb) same = 0;
+        if (ca == EOF || cb == EOF) break;
+    }
+    if (fa) fclose(fa);
+    if (fb) fclose(fb);
+    return same;
+}
+
+static uint64_t file_size(const char *path) {
+    struct stat st;
+    return stat(path, &st) == 0 ? (uint64_t)st.st_size : 0;
+}
+
+// Contadores de cliente + servidor de una corrida
+static void perf_sum(perf_set_t *cps, int have_client, perf_set_t *sps, double out[PC_COUNT]) {
+    double c[PC_COUNT], s[PC_COUNT];
+    perf_collect(sps, s);
+    if (have_client) perf_collect(cps, c);
+    for (int i = 0; i < PC_COUNT; i++) {
+        out[i] = have_client && c[i] >= 0 && s[i] >= 0 ? c[i] + s[i] : -1;
+    }
+}
+
+// ej1: server en workdir (guarda EJ1_REMOTE ahí), client hasta el ACK del FIN
+static run_result_t run_ej1(const bench_opts_t *o, const char *file) {
+    run_result_t res = { 0 };
+    char server[512], client[512], dst[512];
+    snprintf(server, sizeof(server), "%s/server", o->ej1_dir);
+    snprintf(client, sizeof(client), "%s/client", o->ej1_dir);
+    snprintf(dst, sizeof(dst), "%s/%s", o->workdir, EJ1_REMOTE);
+    unlink(dst);
+
+    char *sargv[] = { server, NULL };
+    perf_set_t sps, cps;
+    pid_t spid = spawn(sargv, o->workdir, NULL, o->srv_ns, &sps);
+    if (spid < 0) return res;
+    usleep(200000);   // que llegue a hacer bind()
+
+    char *cargv[] = { client, (char *)o->host, EJ1_CRED, (char *)file, EJ1_REMOTE, NULL };
+    struct rusage cru, sru;
+    uint64_t t0 = now_us();
+    pid_t cpid = spawn(cargv, NULL, NULL, o->cli_ns, &cps);
+    int status = cpid < 0 ? -1 : wait_for(cpid, o->timeout_s * 1000, &cru);
+    uint64_t t1 = now_us();
+
+    // el servidor de ej1 no termina solo
+    kill(spid, SIGTERM);
+    wait_for(spid, 1000, &sru);
+    perf_sum(&cps, cpid >= 0, &sps, res.perf);
+
+    res.ok = status >= 0 && WIFEXITED(status) && WEXITSTATUS(status) == 0 &&
+             same_file(file, dst);
+    res.wall_ms = (double)(t1 - t0) / 1e3;
+    res.bytes = file_size(file);
+    res.cpu_client_us = cpid < 0 ? 0 : rusage_us(&cru);
+    res.cpu_server_us = rusage_us(&sru);
+    return res;
+}
+
+// ej2: tcp_server -B descarta lo recibido y termina con la conexión; el tiempo
+// se cuenta hasta ese momento (todo entregado), no hasta que el emisor cierra
+static run_result_t run_tcp(const bench_opts_t *o, const char *file) {
+    run_result_t res = { 0 };
+    char server[512], client[512], log[512];
+    snprintf(server, sizeof(server), "%s/tcp_server", o->ej2_dir);
+    snprintf(client, sizeof(client), "%s/tcp_client", o->ej2_dir);
+    snprintf(log, sizeof(log), "%s/tcp_server.log", o->workdir);
+
+    char *sargv[] = { server, "-B", "-i", "0", NULL };
+    perf_set_t sps, cps;
+    pid_t spid = spawn(sargv, o->workdir, log, o->srv_ns, &sps);
+    if (spid < 0) return res;
+    usleep(200000);
+
+    char *cargv[] = { client, (char *)o->host, "-F", (char *)file, "-i", "0", NULL };
+    struct rusage cru, sru;
+    uint64_t t0 = now_us();
+    pid_t cpid = spawn(cargv, NULL, NULL, o->cli_ns, &cps);
+    int cstatus = cpid < 0 ? -1 : wait_for(cpid, o->timeout_s * 1000, &cru);
+    int sstatus = wait_for(spid, o->timeout_s * 1000, &sru);
+    uint64_t t1 = now_us();
+    perf_sum(&cps, cpid >= 0, &sps, res.perf);
+
+    // bytes recibidos según el sumidero ("RESUMEN bulk rx: bytes=N")
+    unsigned long long got = 0;
+    FILE *f = fopen(log, "r");
+    if (f) {
+        char line[256];
+        while (fgets(line, sizeof(line), f)) {
+            sscanf(line, "RESUMEN bulk rx: bytes=%llu", &got);
+        }
+        fclose(f);
+    }
+
+    res.bytes = file_size(file);
+    res.ok = cstatus >= 0 && WIFEXITED(cstatus) && WEXITSTATUS(cstatus) == 0 &&
+             sstatus >= 0 && got == res.bytes;
+    res.wall_ms = (double)(t1 - t0) / 1e3;
+    res.cpu_client_us = cpid < 0 ? 0 : rusage_us(&cru);
+    res.cpu_server_us = rusage_us(&sru);
+    return res;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Corre reps transferencias y escribe una fila del reporte (medianas)
+static void bench_one(const bench_opts_t *o, FILE *csv, const char *profile,
+                      const char *transport, const char *file) {
+    double wall[MAX_REPS];
+    double cpu_c = 0, cpu_s = 0;
+    double perf[PC_COUNT] = { 0 };
+    int perf_ok[PC_COUNT] = { 0 };
+    int ok = 0;
+    uint64_t bytes = 0;
+
+    for (int r = 0; r < o->reps; r++) {
+        run_result_t res = strcmp(transport, "ej1") == 0 ? run_ej1(o, file)
+                                                         : run_tcp(o, file);
+        bytes = res.bytes;
+        if (!res.ok) continue;
+        wall[ok++] = res.wall_ms;
+        cpu_c += res.cpu_client_us;
+        cpu_s += res.cpu_server_us;
+        for (int i = 0; i < PC_COUNT; i++) {
+            if (res.perf[i] < 0) continue;
+            perf[i] += res.perf[i];
+            perf_ok[i]++;
+        }
+    }
+
+    const char *base = strrchr(file, '/') ? strrchr(file, '/') + 1 : file;
+    if (ok == 0) {
+        printf("  %-6s %-5s %-18s %10llu   (falló en las %d corridas)\n", profile,
+               transport, base, (unsigned long long)bytes, o->reps);
+        fprintf(csv, "%s,%s,%s,%llu,%d,0,,,,,,,,,,,,\n", profile, transport, base,
+                (unsigned long long)bytes, o->reps);
+        return;
+    }
+
+    qsort(wall, (size_t)ok, sizeof(double), cmp_double);
+    double median = wall[ok / 2];
+    double goodput = median > 0 ? (double)bytes * 8.0 / (median * 1e3) : 0;  // Mbit/s
+    cpu_c /= ok;
+    cpu_s /= ok;
+    double ns_per_byte = bytes ? (cpu_c + cpu_s) * 1e3 / (double)bytes : 0;
+
+    // contadores por MB transferido (promedio de las corridas con dato)
+    char per_mb[PC_COUNT][32], ipc[32] = "";
+    for (int i = 0; i < PC_COUNT; i++) {
+        per_mb[i][0] = '\0';
+        if (perf_ok[i] > 0 && bytes > 0) {
+            perf[i] /= perf_ok[i];
+            snprintf(per_mb[i], sizeof(per_mb[i]), "%.1f", perf[i] / ((double)bytes / 1e6));
+        }
+    }
+    if (per_mb[PC_CYCLES][0] && per_mb[PC_INSTR][0] && perf[PC_CYCLES] > 0) {
+        snprintf(ipc, sizeof(ipc), "%.2f", perf[PC_INSTR] / perf[PC_CYCLES]);
+    }
+
+    printf("  %-6s %-5s %-18s %10llu %3d/%-3d %10.1f %10.2f %9.2f %9.2f %9.1f %10s %5s %9s\n",
+           profile, transport, base, (unsigned long long)bytes, ok, o->reps, median, goodput,
+           cpu_c / 1e3, cpu_s / 1e3, ns_per_byte,
+           per_mb[PC_CYCLES][0] ? per_mb[PC_CYCLES] : "-", ipc[0] ? ipc : "-",
+           per_mb[PC_CTXSW][0] ? per_mb[PC_CTXSW] : "-");
+    fprintf(csv, "%s,%s,%s,%llu,%d,%d,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.1f,%s,%s,%s,%s,%s\n",
+            profile, transport, base, (unsigned long long)bytes, o->reps, ok, median, wall[0],
+            wall[ok - 1], goodput, cpu_c / 1e3, cpu_s / 1e3, ns_per_byte, per_mb[PC_CYCLES],
+            per_mb[PC_INSTR], per_mb[PC_CACHE_MISS], per_mb[PC_CTXSW], ipc);
+    fflush(csv);
+}
+
+static int keep_running = 1;
+
+static void on_signal(int sig) {
+    (void)sig;
+    keep_running = 0;
+}
+
+int main(int argc, char *argv[]) {
+    bench_opts_t o = { "../ej1", "../ej2", "127.0.0.1", "lo", NULL, 3, 120, "", "" };
+    const char *files[MAX_FILES];
+    int n_files = 0;
+    const char *only = NULL;        // -p: lista de perfiles a correr
+    const char *report = "transport_report.csv";
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-f") == 0 && i + 1 < argc && n_files < MAX_FILES) {
+            files[n_files++] = argv[++i];
+        } else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+            only = argv[++i];
+        } else if (strcmp(argv[i], "-P") == 0 && i + 1 < argc && n_profiles < MAX_PROFILES) {
+            // perfil propio: nombre=argumentos de netem
+            char *def = argv[++i];
+            char *eq = strchr(def, '=');
+            if (!eq) continue;
+            *eq = '\0';
+            profiles[n_profiles++] = (profile_t){ def, eq + 1 };
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            o.reps = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            o.timeout_s = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-H") == 0 && i + 1 < argc) {
+            o.host = argv[++i];
+        } else if (strcmp(argv[i], "-I") == 0 && i + 1 < argc) {
+            o.iface = argv[++i];
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%63[^,],%63s", o.srv_ns, o.cli_ns) != 2) {
+                fprintf(stderr, "-n espera <ns_servidor>,<ns_cliente>\n");
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[i], "-1") == 0 && i + 1 < argc) {
+            o.ej1_dir = argv[++i];
+        } else if (strcmp(argv[i], "-2") == 0 && i + 1 < argc) {
+            o.ej2_dir = argv[++i];
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            report = argv[++i];
+        } else {
+            fprintf(stderr,
+                    "Uso: %s [-f archivo]... [-p perfil,..] [-P nombre=netem] [-r reps]\n"
+                    "          [-t timeout_s] [-H ip] [-I iface] [-1 dir_ej1] [-2 dir_ej2]\n"
+                    "          [-n ns_srv,ns_cli] [-o reporte.csv]\n"
+                    "  -f  archivo a transferir (por defecto los de ej1/src)\n"
+                    "  -p  perfiles a correr (por defecto todos: none,lan,inter,lossy)\n"
+                    "  -P  agregar un perfil, p.ej. -P sat='delay 300ms loss 1%%'\n"
+                    "  -I  interfaz donde aplicar netem (por defecto lo; hace falta root)\n"
+                    "  -n  correr servidores y clientes en esos namespaces (ver\n"
+                    "      netns_rig.sh; -H es la IP del servidor en el veth)\n",
+                    argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (o.reps < 1) o.reps = 1;
+    if (o.reps > MAX_REPS) o.reps = MAX_REPS;
+
+    static char def_files[2][512];
+    if (n_files == 0) {
+        snprintf(def_files[0], sizeof(def_files[0]), "%s/src/archivo_20kB.bin", o.ej1_dir);
+        snprintf(def_files[1], sizeof(def_files[1]), "%s/src/g21.data", o.ej1_dir);
+        files[n_files++] = def_files[0];
+        files[n_files++] = def_files[1];
+    }
+
+    // rutas absolutas: los servidores corren con otro cwd
+    static char abs_ej1[4096], abs_ej2[4096];
+    if (!realpath(o.ej1_dir, abs_ej1) || !realpath(o.ej2_dir, abs_ej2)) {
+        perror("directorio de ej1/ej2");
+        return EXIT_FAILURE;
+    }
+    o.ej1_dir = abs_ej1;
+    o.ej2_dir = abs_ej2;
+    static char abs_files[MAX_FILES][4096];
+    for (int i = 0; i < n_files; i++) {
+        if (!realpath(files[i], abs_files[i])) {
+            perror(files[i]);
+            return EXIT_FAILURE;
+        }
+        files[i] = abs_files[i];
+    }
+
+    char tmpl[] = "/tmp/transport_bench.XXXXXX";
+    if (!(o.workdir = mkdtemp(tmpl))) {
+        perror("mkdtemp");
+        return EXIT_FAILURE;
+    }
+
+    FILE *csv = fopen(report, "w");
+    if (!csv) {
+        perror(report);
+        return EXIT_FAILURE;
+    }
+    fprintf(csv, "profile,transport,file,bytes,reps,ok,time_ms,time_ms_min,time_ms_max,"
+                 "goodput_mbps,cpu_client_ms,cpu_server_ms,cpu_ns_per_byte,cycles_per_mb,"
+                 "instructions_per_mb,cache_misses_per_mb,ctx_switches_per_mb,ipc\n");
+
+    // Ctrl-C: terminar la corrida actual y sacar netem de la interfaz
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    printf("  %-6s %-5s %-18s %10s %7s %10s %10s %9s %9s %9s %10s %5s %9s\n", "perfil",
+           "proto", "archivo", "bytes", "ok", "t_ms", "Mbit/s", "cpu_cli", "cpu_srv", "ns/byte",
+           "ciclos/MB", "IPC", "ctxsw/MB");
+    for (int p = 0; p < n_profiles && keep_running; p++) {
+        const profile_t *pr = &profiles[p];
+        if (only) {
+            // coincidencia exacta dentro de la lista separada por comas
+            size_t len = strlen(pr->name);
+            const char *hit = only;
+            while ((hit = strstr(hit, pr->name)) &&
+                   !((hit == only || hit[-1] == ',') && (hit[len] == ',' || hit[len] == '\0'))) {
+                hit += len;
+            }
+            if (!hit) continue;
+        }
+        if (pr->netem[0] && run_tc("replace", &o, pr->netem) < 0) {
+            printf("  %-6s (no se pudo aplicar netem \"%s\" en %s; ¿root? ¿sch_netem?)\n",
+                   pr->name, pr->netem, o.iface);
+            fprintf(csv, "%s,,,,,0,,,,,,,,,,,,\n", pr->name);
+            continue;
+        }
+        for (int f = 0; f < n_files && keep_running; f++) {
+            bench_one(&o, csv, pr->name, "ej1", files[f]);
+            bench_one(&o, csv, pr->name, "tcp", files[f]);
+        }
+        if (pr->netem[0]) run_tc("del", &o, NULL);
+    }
+
+    fclose(csv);
+    printf("Reporte: %s\n", report);
+
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", o.workdir, EJ1_REMOTE);
+    unlink(path);
+    snprintf(path, sizeof(path), "%s/tcp_server.log", o.workdir);
+    unlink(path);
+    rmdir(o.workdir);
+    return EXIT_SUCCESS;
+}
@@ -1,11 +1,35 @@
 // client.c
+#define _POSIX_C_SOURCE 200809L   // clock_gettime
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <arpa/inet.h>
 #include <sys/time.h>
+#include <time.h>
 #include "protocol.h"
+#include "trace.h"
+#include "qlog.h"
+
+#define ACK_TIMEOUT_MS 2000
+
+static qlog_t *ql;   // traza de la sesión (-t)
+static double srtt_ms;
+static char ack_msg[64];   // payload del último ACK aceptado (p.ej. "RESUME <offset>")
+
+static double mono_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e3 + (double)ts.tv_nsec / 1e6;
+}
+
+// Cierra la traza y espera a que llegue al disco
+static void end_trace(const char *reason) {
+    qlog_event(ql, "connectivity:connection_closed", "\"reason\":\"%s\"", reason);
+    qlog_close(ql);
+    ql = NULL;
+    qlog_shutdown();
+}
 
 // Función auxiliar para enviar y esperar ACK con reintentos
 int send_and_wait(int sockfd, struct sockaddr_in *serv_addr, struct pdu *packet, int data_len) {
@@ -16,14 +40,40 @@ int send_and_wait(int sockfd, struct sockaddr_in *serv_addr, struct pdu *packet,
     
     while (retries < 5) { // Max 5 reintentos
         // Enviar paquete
+        if (retries > 0) TRACE3(retransmit, packet->type, packet->seq_num, retries);
+        else TRACE3(pdu_send, packet->type, packet->seq_num, data_len);
+        qlog_event(ql, "transport:packet_sent", "\"type\":\"%s\",\"seq\":%d,\"len\":%d,"
+                   "\"retransmit\":%s", qlog_type_name(packet->type), packet->seq_num,
+                   2 + data_len, retries > 0 ? "true" : "false");
+        double sent_ms = mono_ms();
         sendto(sockfd, packet, 2 + data_len, 0, (struct sockaddr *)serv_addr, sizeof(*serv_addr));
+        // Stop & Wait: ventana de un paquete
+        qlog_event(ql, "recovery:metrics_updated", "\"bytes_in_flight\":%d,\"congestion_window\":1",
+                   2 + data_len);
+        qlog_event(ql, "recovery:loss_timer_updated", "\"event_type\":\"set\",\"timer_type\":\"ack\","
+                   "\"delta\":%d", ACK_TIMEOUT_MS);
         
         // Intentar recibir ACK
         int n = recvfrom(sockfd, buffer, BUF_SIZE, 0, (struct sockaddr *)serv_addr, &len);
         
         if (n > 0) {
             ack = (struct pdu *)buffer;
+            qlog_event(ql, "transport:packet_received", "\"type\":\"%s\",\"seq\":%d,\"len\":%d",
+                       qlog_type_name(ack->type), ack->seq_num, n);
             if (ack->type == TYPE_ACK && ack->seq_num == packet->seq_num) {
+                TRACE2(ack_recv, packet->seq_num, retries);
+                qlog_event(ql, "recovery:loss_timer_updated", "\"event_type\":\"cancelled\","
+                           "\"timer_type\":\"ack\"");
+                if (retries == 0) {
+                    // Karn: sólo se muestrea el RTT de paquetes sin retransmitir
+                    double rtt = mono_ms() - sent_ms;
+                    srtt_ms = srtt_ms == 0 ? rtt : 0.875 * srtt_ms + 0.125 * rtt;
+                    qlog_event(ql, "recovery:metrics_updated", "\"latest_rtt\":%.3f,"
+                               "\"smoothed_rtt\":%.3f,\"bytes_in_flight\":0", rtt, srtt_ms);
+                }
+                int m = n - 2 < (int)sizeof(ack_msg) - 1 ? n - 2 : (int)sizeof(ack_msg) - 1;
+                memcpy(ack_msg, ack->payload, (size_t)m);
+                ack_msg[m] = '\0';
                 return 1; // Éxito
             }
             // Si recibimos error en payload
@@ -32,6 +82,9 @@ int send_and_wait(int sockfd, struct sockaddr_in *serv_addr, struct pdu *packet,
                 return 0;
             }
         } else {
+            TRACE3(timeout, packet->type, packet->seq_num, retries);
+            qlog_event(ql, "recovery:loss_timer_updated", "\"event_type\":\"expired\","
+                       "\"timer_type\":\"ack\"");
             printf("Timeout... reintentando\n");
         }
         retries++;
@@ -40,8 +93,18 @@ int send_and_wait(int sockfd, struct sockaddr_in *serv_addr, struct pdu *packet,
 }
 
 int main(int argc, char *argv[]) {
-    if (argc != 5) {
-        printf("Uso: %s <IP Servidor> <Credencial> <Archivo Local> <Nombre Remoto>\n", argv[0]);
+    const char *trace_path = NULL;
+    int resume = 0;
+    int bad_args = argc < 5;
+    for (int i = 5; i < argc && !bad_args; i++) {
+        if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) trace_path = argv[++i];
+        else if (strcmp(argv[i], "-r") == 0) resume = 1;
+        else bad_args = 1;
+    }
+    if (bad_args) {
+        printf("Uso: %s <IP Servidor> <Credencial> <Archivo Local> <Nombre Remoto> [-t traza.qlog] [-r]\n"
+               "  -r  seguir una subida cortada desde lo que el servidor tiene en su diario (-j)\n",
+               argv[0]);
         return -1;
     }
 
@@ -50,8 +113,8 @@ int main(int argc, char *argv[]) {
     struct timeval tv;
 
     // Configurar Timeout de 2 segundos
-    tv.tv_sec = 2;
-    tv.tv_usec = 0;
+    tv.tv_sec = ACK_TIMEOUT_MS / 1000;
+    tv.tv_usec = (ACK_TIMEOUT_MS % 1000) * 1000;
 
     if ((sockfd = socket(AF_INET, SOCK_DGRAM, 0)) < 0) {
         perror("Socket creation failed");
@@ -67,38 +130,74 @@ int main(int argc, char *argv[]) {
     serv_addr.sin_addr.s_addr = inet_addr(argv[1]);
 
     struct pdu packet;
+    TRACE2(session_new, ntohl(serv_addr.sin_addr.s_addr), SERVER_PORT);
+    if (trace_path) {
+        char peer[32];
+        snprintf(peer, sizeof(peer), "%s:%d", argv[1], SERVER_PORT);
+        ql = qlog_open(trace_path, "client", peer);
+        qlog_event(ql, "connectivity:connection_started", "\"file\":\"%s\"", argv[4]);
+    }
     
     // --- FASE 1: HELLO ---
     printf("Enviando HELLO...\n");
+    TRACE1(phase, TYPE_HELLO);
+    qlog_event(ql, "transport:state_updated", "\"new\":\"hello\"");
     packet.type = TYPE_HELLO;
     packet.seq_num = 0;
     strncpy(packet.payload, argv[2], MAX_PAYLOAD_SIZE); // Credencial
     if (!send_and_wait(sockfd, &serv_addr, &packet, strlen(argv[2]))) {
         printf("Fallo HELLO\n"); 
+        end_trace("hello_failed");
         close(sockfd);
         return -1;
     }
 
     // --- FASE 2: WRQ ---
     printf("Enviando WRQ...\n");
+    TRACE1(phase, TYPE_WRQ);
+    qlog_event(ql, "transport:state_updated", "\"new\":\"wrq\"");
     packet.type = TYPE_WRQ;
     packet.seq_num = 1;
     strncpy(packet.payload, argv[4], MAX_PAYLOAD_SIZE);  // Nombre remoto
+    // -r: "nombre\0R"; un servidor sin diario sólo ve el nombre
+    int wrq_len = strlen(argv[4]);
+    if (resume && wrq_len + 2 <= MAX_PAYLOAD_SIZE) {
+        packet.payload[wrq_len + 1] = 'R';
+        wrq_len += 2;
+    }
     
-    if (!send_and_wait(sockfd, &serv_addr, &packet, strlen(argv[4]))) {
+    if (!send_and_wait(sockfd, &serv_addr, &packet, wrq_len)) {
         printf("Fallo WRQ\n");
+        end_trace("wrq_failed");
         close(sockfd);
         return -1;
     }
 
 
     // --- FASE 3: DATA ---
+    TRACE1(phase, TYPE_DATA);
+    qlog_event(ql, "transport:state_updated", "\"new\":\"data\"");
     FILE *fp = fopen(argv[3], "rb"); // Archivo local
     if (!fp) { 
         perror("No se puede abrir archivo"); 
+        end_trace("local_file");
         close (sockfd); 
         return -1; }
 
+    long offset = 0;
+    if (resume && strncmp(ack_msg, "RESUME ", 7) == 0) {
+        offset = atol(ack_msg + 7);
+        if (fseek(fp, offset, SEEK_SET) < 0) {
+            perror("No se puede reanudar");
+            fclose(fp);
+            end_trace("local_file");
+            close(sockfd);
+            return -1;
+        }
+        printf("Reanudando desde el byte %ld\n", offset);
+        qlog_event(ql, "connectivity:connection_resumed", "\"offset\":%ld", offset);
+    }
+
     int bytes_read;
     int current_seq = 0;
     
@@ -111,6 +210,7 @@ int main(int argc, char *argv[]) {
         if (!send_and_wait(sockfd, &serv_addr, &packet, bytes_read)) {
             printf("Fallo DATA transmission\n"); 
             fclose(fp); 
+            end_trace("data_failed");
             close(sockfd);
             return -1;
         }
@@ -121,11 +221,14 @@ int main(int argc, char *argv[]) {
 
     // --- FASE 4: FIN ---
     printf("Enviando FIN...\n");
+    TRACE1(phase, TYPE_FIN);
+    qlog_event(ql, "transport:state_updated", "\"new\":\"fin\"");
     packet.type = TYPE_FIN;
     packet.seq_num = current_seq;
     send_and_wait(sockfd, &serv_addr, &packet, 0);
 
     printf("Transferencia completada.\n");
+    end_trace("done");
     close(sockfd);
     return 0;
 }
\ No newline at end of file
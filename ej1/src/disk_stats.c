@@ -0,0 +1,120 @@
+// disk_stats.c
+#define _POSIX_C_SOURCE 200809L   // clock_gettime, nanosleep
+#include <stdio.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "disk_stats.h"
+
+static const char *const op_names[DISK_OPS] = { "open", "write", "close", "sync" };
+
+uint64_t disk_now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+}
+
+const char *disk_op_name(int op) {
+    return op >= 0 && op < DISK_OPS ? op_names[op] : "?";
+}
+
+void disk_stats_add(disk_stats_t *s, int op, uint64_t us) {
+    disk_hist_t *h = &s->op[op];
+    int b = us ? 64 - __builtin_clzll(us) : 0;
+    if (b >= DISK_BUCKETS) b = DISK_BUCKETS - 1;
+    h->n++;
+    h->sum_us += us;
+    if (us > h->max_us) h->max_us = us;
+    h->buckets[b]++;
+}
+
+uint64_t disk_hist_percentile(const disk_hist_t *h, double pct) {
+    uint64_t target = (uint64_t)((double)h->n * pct / 100.0), seen = 0;
+    for (int b = 0; b < DISK_BUCKETS; b++) {
+        seen += h->buckets[b];
+        if (seen > target) {
+            uint64_t bound = b ? 1ULL << b : 1;
+            return bound < h->max_us ? bound : h->max_us;
+        }
+    }
+    return h->max_us;
+}
+
+void disk_stats_print(const disk_stats_t *s, const char *tag) {
+    for (int i = 0; i < DISK_OPS; i++) {
+        const disk_hist_t *h = &s->op[i];
+        if (h->n == 0) continue;
+        printf("%s: %-5s n=%llu avg=%.1f us p50<=%llu us p99<=%llu us max=%llu us\n", tag,
+               op_names[i], (unsigned long long)h->n, (double)h->sum_us / (double)h->n,
+               (unsigned long long)disk_hist_percentile(h, 50),
+               (unsigned long long)disk_hist_percentile(h, 99),
+               (unsigned long long)h->max_us);
+    }
+}
+
+int disk_stats_export(const disk_stats_t *s, const char *path) {
+    FILE *fp = fopen(path, "w");
+    if (!fp) return -1;
+    fprintf(fp, "op,le_us,count\n");
+    for (int i = 0; i < DISK_OPS; i++) {
+        for (int b = 0; b < DISK_BUCKETS; b++) {
+            if (s->op[i].buckets[b] == 0) continue;
+            fprintf(fp, "%s,%llu,%llu\n", op_names[i], b ? 1ULL << b : 1ULL,
+                    (unsigned long long)s->op[i].buckets[b]);
+        }
+    }
+    return fclose(fp);
+}
+
+// --- Vigilante ---
+// El hilo principal publica la operación en curso con atómicos (sin locks en
+// el camino de cada fwrite); el vigilante sólo lee, y relee el inicio para
+// descartar lo que haya cambiado mientras armaba el aviso.
+static atomic_ullong watch_start_us;   // 0 => no hay operación en curso
+static atomic_int watch_what;          // op << 16 | sesión
+static atomic_int watch_active;
+static uint64_t watch_stall_us;
+
+static void *watch_thread(void *arg) {
+    (void)arg;
+    uint64_t period = watch_stall_us / 4 ? watch_stall_us / 4 : 1000;
+    struct timespec tick = { (time_t)(period / 1000000ULL), (long)(period % 1000000ULL) * 1000L };
+    uint64_t reported = 0;   // inicio de la última operación avisada
+    for (;;) {
+        nanosleep(&tick, NULL);
+        uint64_t t0 = atomic_load(&watch_start_us);
+        if (t0 == 0 || t0 == reported) continue;
+        uint64_t now = disk_now_us();
+        if (now < t0 || now - t0 < watch_stall_us) continue;
+
+        int what = atomic_load(&watch_what);
+        int active = atomic_load(&watch_active);
+        if (atomic_load(&watch_start_us) != t0) continue;   // ya terminó
+        reported = t0;
+        fprintf(stderr, "ALERTA disco: %s de cliente %d trabado hace %.1f ms;"
+                " %d sesiones sin ACK mientras tanto\n", disk_op_name(what >> 16),
+                what & 0xffff, (double)(now - t0) / 1e3, active);
+    }
+    return NULL;
+}
+
+int disk_watch_start(uint64_t stall_us) {
+    pthread_t th;
+    watch_stall_us = stall_us;
+    if (pthread_create(&th, NULL, watch_thread, NULL) != 0) {
+        perror("disk watch pthread_create");
+        return -1;
+    }
+    pthread_detach(th);
+    return 0;
+}
+
+void disk_watch_begin(int op, int session, int active) {
+    atomic_store(&watch_what, op << 16 | (session & 0xffff));
+    atomic_store(&watch_active, active);
+    atomic_store(&watch_start_us, disk_now_us());
+}
+
+void disk_watch_end(void) {
+    atomic_store(&watch_start_us, 0);
+}
@@ -0,0 +1,42 @@
+// disk_stats.h
+// Latencia de las operaciones de disco del servidor (fopen, fwrite, fclose y
+// los fdatasync de los checkpoints de -j)
+// en histogramas log2 de microsegundos, por sesión y globales, más un
+// vigilante que avisa mientras una operación sigue trabada: el servidor es
+// de un solo hilo, así que un disco lento frena los ACK de todas las sesiones.
+#ifndef DISK_STATS_H
+#define DISK_STATS_H
+
+#include <stdint.h>
+
+enum { DISK_OPEN, DISK_WRITE, DISK_CLOSE, DISK_SYNC, DISK_OPS };
+
+#define DISK_BUCKETS 32   // bucket b: latencias en [2^(b-1), 2^b) us
+
+typedef struct {
+    uint64_t n, sum_us, max_us;
+    uint64_t buckets[DISK_BUCKETS];
+} disk_hist_t;
+
+typedef struct {
+    disk_hist_t op[DISK_OPS];
+} disk_stats_t;
+
+uint64_t disk_now_us(void);
+const char *disk_op_name(int op);
+void disk_stats_add(disk_stats_t *s, int op, uint64_t us);
+// Percentil aproximado (cota superior del bucket), en us
+uint64_t disk_hist_percentile(const disk_hist_t *h, double pct);
+// Una línea por operación con datos: n, avg, p50, p99 y max
+void disk_stats_print(const disk_stats_t *s, const char *tag);
+// CSV op,le_us,count con los buckets no vacíos; -1 si no se pudo escribir
+int disk_stats_export(const disk_stats_t *s, const char *path);
+
+// Vigilante: disk_watch_begin/end rodean cada operación; si una pasa de
+// stall_us sin terminar se avisa por stderr una vez, con la sesión y cuántas
+// sesiones activas quedaron esperando (`active`).
+int  disk_watch_start(uint64_t stall_us);
+void disk_watch_begin(int op, int session, int active);
+void disk_watch_end(void);
+
+#endif
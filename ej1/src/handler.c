@@ -0,0 +1,471 @@
+// handler.c
+#define _POSIX_C_SOURCE 200809L   // clock_gettime, ftruncate, fdatasync
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/stat.h>
+#include "protocol.h"
+#include "handler.h"
+#include "journal.h"
+#include "prof.h"
+#include "trace.h"
+#include "slow.h"
+
+client_t clients[MAX_CLIENTS];
+handler_io_t hio = { -1, NULL, NULL, NULL, NULL };
+
+disk_stats_t disk_total;
+uint64_t stall_us = 100000;
+static FILE *alerts_fp;
+unsigned sessions_started;
+int checkpoint_every = 64;
+
+#ifdef SERVER_PROFILE
+prof_phase_t prof_phases[PH_COUNT];
+double prof_ns_per_tick = 1.0;
+volatile sig_atomic_t prof_dump_requested;
+#endif
+#ifdef TEST_SLOW
+slow_opts_t slow = { 0, 0, 0, 100 };
+#endif
+
+static const char *state_names[] = { "none", "auth", "wrq_done", "data" };
+
+// Cambio de estado con su evento en la traza
+static void set_state(client_t *cli, client_state_t st) {
+    qlog_event(cli->qlog, "transport:state_updated", "\"old\":\"%s\",\"new\":\"%s\"",
+               state_names[cli->state], state_names[st]);
+    cli->state = st;
+}
+
+static int count_active(void) {
+    int n = 0;
+    for (int i = 0; i < MAX_CLIENTS; i++) n += clients[i].active;
+    return n;
+}
+
+// Alerta de disco lento: a stderr, a la traza de la sesión y (con -D) a
+// disk_alerts.csv, con todas las sesiones que se quedaron sin ACK
+static void disk_alert(int idx, int op, uint64_t us) {
+    client_t *cli = &clients[idx];
+    char affected[64] = "";
+    size_t used = 0;
+    for (int i = 0; i < MAX_CLIENTS && used < sizeof(affected); i++) {
+        if (clients[i].active) {
+            used += snprintf(affected + used, sizeof(affected) - used, "%s%d", used ? ";" : "", i);
+        }
+    }
+    fprintf(stderr, "ALERTA disco: %s de cliente %d (%s) tardó %.1f ms; sesiones afectadas: %s\n",
+           disk_op_name(op), idx, cli->path, us / 1e3, affected);
+    qlog_event(cli->qlog, "disk:stall", "\"op\":\"%s\",\"latency_ms\":%.3f,\"affected\":\"%s\"",
+               disk_op_name(op), us / 1e3, affected);
+
+    if (!hio.disk_dir) return;
+    if (!alerts_fp) {
+        char path[512];
+        snprintf(path, sizeof(path), "%s/disk_alerts.csv", hio.disk_dir);
+        alerts_fp = fopen(path, "a");
+        if (!alerts_fp) return;
+        if (ftell(alerts_fp) == 0) {
+            fprintf(alerts_fp, "t_s,op,session,peer,file,latency_ms,affected\n");
+        }
+    }
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    fprintf(alerts_fp, "%ld.%06ld,%s,%d,%s:%d,%s,%.3f,%s\n", (long)now.tv_sec, now.tv_nsec / 1000,
+            disk_op_name(op), idx, inet_ntoa(cli->addr.sin_addr), ntohs(cli->addr.sin_port),
+            cli->path, us / 1e3, affected);
+    fflush(alerts_fp);
+}
+
+// disk_begin/disk_end rodean cada fopen/fwrite/fclose de una sesión
+static uint64_t disk_begin(int idx, int op) {
+    disk_watch_begin(op, idx, count_active());
+    return disk_now_us();
+}
+
+static void disk_end(int idx, int op, uint64_t t0) {
+    uint64_t us = disk_now_us() - t0;
+    disk_watch_end();
+    disk_stats_add(&clients[idx].disk, op, us);
+    disk_stats_add(&disk_total, op, us);
+    if (us >= stall_us) disk_alert(idx, op, us);
+}
+
+// Checkpoint del diario: lo escrito hasta acá queda en disco y recién
+// después se anota el offset
+static void checkpoint(int idx) {
+    client_t *cli = &clients[idx];
+    if (cli->jslot < 0 || !cli->fp) return;
+    uint64_t t0 = disk_begin(idx, DISK_SYNC);
+    fflush(cli->fp);
+    fdatasync(fileno(cli->fp));
+    disk_end(idx, DISK_SYNC, t0);
+
+    journal_rec_t r;
+    memset(&r, 0, sizeof(r));
+    r.active = 1;
+    r.id = cli->id;
+    r.ip = cli->addr.sin_addr.s_addr;
+    r.port = cli->addr.sin_port;
+    r.state = (uint8_t)cli->state;
+    r.expected_seq = cli->expected_seq;
+    r.offset = cli->bytes;
+    snprintf(r.path, sizeof(r.path), "%s", cli->path);
+    journal_write(cli->jslot, &r);
+    cli->unsynced = 0;
+}
+
+// Reabre el archivo de una subida en el offset ya confirmado: lo que haya
+// después no llegó a tener checkpoint (o ACK). Si el archivo es más corto
+// que el offset (lo pisaron después) se sigue desde 0 y *offset queda en 0.
+static FILE *reopen_at(const char *path, long *offset) {
+    FILE *fp = fopen(path, "r+b");
+    struct stat st;
+    if (fp && fstat(fileno(fp), &st) == 0 && st.st_size < *offset) {
+        fprintf(stderr, "%s: mide %lld bytes y el diario dice %ld, se empieza de cero\n", path,
+                (long long)st.st_size, *offset);
+        *offset = 0;
+    }
+    if (!fp || ftruncate(fileno(fp), *offset) < 0 || fseek(fp, *offset, SEEK_SET) < 0) {
+        perror(path);
+        if (fp) fclose(fp);
+        return NULL;
+    }
+    return fp;
+}
+
+// Libera el slot cerrando la traza
+static void end_session(client_t *cli, const char *reason) {
+    qlog_event(cli->qlog, "connectivity:connection_closed", "\"reason\":\"%s\",\"bytes\":%ld",
+               reason, cli->bytes);
+    qlog_close(cli->qlog);
+    cli->qlog = NULL;
+    cli->active = 0;
+}
+
+void init_clients(void) {
+    for (int i = 0; i < MAX_CLIENTS; i++) clients[i].active = 0;
+}
+
+int get_client_index(struct sockaddr_in *cli_addr) {
+    int free_idx = -1;
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        if (clients[i].active) {
+            if (clients[i].addr.sin_addr.s_addr == cli_addr->sin_addr.s_addr &&
+                clients[i].addr.sin_port == cli_addr->sin_port) {
+                return i;
+            }
+        } else {
+            if (free_idx == -1) free_idx = i;
+        }
+    }
+    return free_idx; // Retorna índice libre si es nuevo
+}
+
+static void send_ack(struct sockaddr_in *addr, uint8_t seq, char *msg, qlog_t *ql) {
+    PROF_BEGIN(PH_SEND_ACK);
+    struct pdu response;
+    response.type = TYPE_ACK;
+    response.seq_num = seq;
+    memset(response.payload, 0, MAX_PAYLOAD_SIZE);
+    if(msg) strncpy(response.payload, msg, MAX_PAYLOAD_SIZE);
+    TRACE3(ack_send, ntohs(addr->sin_port), seq, msg != NULL);
+    SLOW_ACK();
+
+    // PDU total size: 2 bytes header + payload length
+    if (hio.send) {
+        hio.send(&response, 2 + (msg ? strlen(msg) : 0), addr);
+    } else {
+        sendto(hio.sockfd, &response, 2 + (msg ? strlen(msg) : 0), 0,
+               (struct sockaddr *)addr, sizeof(*addr));
+    }
+    qlog_event(ql, "transport:packet_sent", "\"type\":\"ACK\",\"seq\":%d,\"len\":%zu%s%s%s",
+               seq, 2 + (msg ? strlen(msg) : 0), msg ? ",\"error\":\"" : "", msg ? msg : "",
+               msg ? "\"" : "");
+    PROF_END(PH_SEND_ACK);
+}
+
+// --- MÁQUINA DE ESTADOS ---
+static int dispatch(int idx, struct pdu *packet, int n, struct sockaddr_in *cli_addr) {
+    client_t *cli = &clients[idx];
+
+    // FASE 1: HELLO
+    if (packet->type == TYPE_HELLO && cli->state == STATE_NONE) {
+        printf("Cliente %d: HELLO recibido con credencial: %.*s\n", idx, n-2, packet->payload);
+        char credencial_valida[] = "g21-0e29"; // Credencial de la catedra
+
+        if (strncmp(packet->payload, credencial_valida, strlen(credencial_valida)) == 0) {
+            // Credencial OK -> Enviar ACK vacío (éxito)
+            send_ack(cli_addr, 0, NULL, cli->qlog);
+            TRACE3(phase, idx, cli->state, STATE_AUTH);
+            set_state(cli, STATE_AUTH);
+            cli->expected_seq = 1;
+        } else {
+            // Credencial MALA -> Enviar ACK con mensaje de error
+            printf("Cliente %d: Credencial invalida rechazadas.\n", idx);
+            send_ack(cli_addr, 0, "Credencial Invalida", cli->qlog);
+            TRACE1(auth_reject, idx);
+            // Mantenemos el estado en NONE o reiniciamos
+            end_session(cli, "auth_failed");
+        }
+    }
+    // FASE 2: WRQ
+    else if (packet->type == TYPE_WRQ && cli->state == STATE_AUTH) {
+        if (packet->seq_num != 1) return 0; // Seq incorrecto
+
+        // el largo se mide sólo sobre lo recibido y la copia no pasa de
+        // filename: un nombre largo se muestra cortado y se rechaza abajo
+        size_t plen = (size_t)(n - 2);
+        size_t flen = strnlen(packet->payload, plen);
+        char filename[20] = "";
+        memcpy(filename, packet->payload, flen < sizeof(filename) - 1 ? flen : sizeof(filename) - 1);
+        // cliente con -r: "nombre\0R", pide seguir una subida cortada
+        int resume = flen + 1 < plen && plen == flen + 2 && packet->payload[flen + 1] == 'R';
+
+        printf("Cliente %d: WRQ para archivo %s%s\n", idx, filename, resume ? " (reanudar)" : "");
+
+        // Validar nombre (4-10 chars)
+        if (flen < 4 || flen > 10) {
+           send_ack(cli_addr, 1, "Error Name", cli->qlog);
+           // Resetear cliente o manejar error
+           return 0;
+        }
+
+        snprintf(cli->path, sizeof(cli->path), "%s", filename);
+        journal_rec_t jr = { 0 };
+        int jslot = resume ? journal_find(cli_addr->sin_addr.s_addr, cli->path, &jr) : -1;
+        uint64_t t0 = disk_begin(idx, DISK_OPEN);
+        long offset = (long)jr.offset;
+        if (jslot >= 0 && (cli->fp = reopen_at(cli->path, &offset)) != NULL) {
+            journal_claim(jslot);
+            cli->bytes = offset;
+        } else {
+            jslot = -1;
+            cli->fp = hio.open ? hio.open(cli->path) : fopen(cli->path, "wb");
+        }
+        // los demás registros de este archivo ya no valen: o se retomó el más
+        // nuevo o se vuelve a escribir de cero, y un -r posterior no debe
+        // tomar un offset viejo
+        if (cli->fp) {
+            journal_forget(cli_addr->sin_addr.s_addr, cli->path);
+            if (jslot < 0) jslot = journal_alloc();
+        }
+        disk_end(idx, DISK_OPEN, t0);
+
+        if (cli->fp) {
+            char resumed[32];
+            snprintf(resumed, sizeof(resumed), "RESUME %ld", cli->bytes);
+            if (cli->bytes) {
+                printf("Cliente %d: se retoma la sesión %u desde el byte %ld\n", idx, jr.id,
+                       cli->bytes);
+                qlog_event(cli->qlog, "connectivity:connection_resumed", "\"from_session\":%u,"
+                           "\"offset\":%ld", jr.id, cli->bytes);
+            }
+            // el offset va en el ACK (con seq 1 el cliente lo toma como éxito)
+            send_ack(cli_addr, 1, cli->bytes ? resumed : NULL, cli->qlog);
+            TRACE3(phase, idx, cli->state, STATE_DATA);
+            set_state(cli, STATE_DATA);
+            cli->expected_seq = 0;
+            cli->jslot = jslot;
+            checkpoint(idx);
+        } else {
+            send_ack(cli_addr, 1, "Error FS", cli->qlog);
+        }
+    }
+    // FASE 3: DATA
+    else if (packet->type == TYPE_DATA && cli->state == STATE_DATA) {
+        if (packet->seq_num == cli->expected_seq) {
+            TRACE3(data_accept, idx, packet->seq_num, n - 2);
+            // Escribir en archivo (n - 2 bytes de header)
+            PROF_BEGIN(PH_FWRITE);
+            uint64_t t0 = disk_begin(idx, DISK_WRITE);
+            fwrite(packet->payload, 1, n - 2, cli->fp);
+            SLOW_WRITE();
+            disk_end(idx, DISK_WRITE, t0);
+            PROF_END(PH_FWRITE);
+            qlog_event(cli->qlog, "transport:data_moved", "\"offset\":%ld,\"len\":%d,\"to\":\"file\"",
+                       cli->bytes, n - 2);
+            cli->bytes += n - 2;
+            if (cli->jslot >= 0 && ++cli->unsynced >= checkpoint_every) checkpoint(idx);
+            // Enviar ACK
+            send_ack(cli_addr, cli->expected_seq, NULL, cli->qlog);
+            // Alternar secuencia (0->1, 1->0)
+            cli->expected_seq = 1 - cli->expected_seq;
+        } else {
+            // Retransmisión de ACK anterior (paquete duplicado)
+            TRACE2(data_dup, idx, packet->seq_num);
+            qlog_event(cli->qlog, "transport:packet_dropped", "\"type\":\"DATA\",\"seq\":%d,"
+                       "\"trigger\":\"duplicate\"", packet->seq_num);
+            send_ack(cli_addr, 1 - cli->expected_seq, NULL, cli->qlog);
+        }
+    }
+    // FASE 4: FIN
+    else if (packet->type == TYPE_FIN && cli->state == STATE_DATA) {
+        printf("Cliente %d: FIN recibido. Cerrando.\n", idx);
+        if (cli->fp) {
+            uint64_t t0 = disk_begin(idx, DISK_CLOSE);
+            fclose(cli->fp);
+            disk_end(idx, DISK_CLOSE, t0);
+        }
+        journal_release(cli->jslot);
+        cli->jslot = -1;
+        send_ack(cli_addr, packet->seq_num, NULL, cli->qlog);
+        char tag[32];
+        snprintf(tag, sizeof(tag), "Disco cliente %d", idx);
+        disk_stats_print(&cli->disk, tag);
+        if (hio.disk_dir) {
+            char path[512];
+            snprintf(path, sizeof(path), "%s/disk_latency.csv", hio.disk_dir);
+            disk_stats_export(&disk_total, path);
+        }
+
+        // Liberar slot
+        TRACE3(phase, idx, cli->state, STATE_NONE);
+        set_state(cli, STATE_NONE);
+        end_session(cli, "fin");
+        cli->fp = NULL;
+        return 1;
+    }
+    else {
+        // Paquete fuera de secuencia o estado incorrecto: ignorar silenciosamente
+    }
+    return 0;
+}
+
+int handle_packet(char *buffer, int n, struct sockaddr_in *cli_addr) {
+    struct pdu *packet = (struct pdu *)buffer;
+    PROF_BEGIN(PH_LOOKUP);
+    int idx = get_client_index(cli_addr);
+    PROF_END(PH_LOOKUP);
+
+    if (idx == -1) {
+        printf("Servidor lleno, ignorando cliente.\n");
+        return 0;
+    }
+
+    client_t *cli = &clients[idx];
+
+    // Si es un cliente nuevo en este slot
+    if (!cli->active) {
+        cli->active = 1;
+        cli->addr = *cli_addr;
+        cli->state = STATE_NONE;
+        cli->expected_seq = 0;
+        cli->bytes = 0;
+        cli->qlog = NULL;
+        cli->path[0] = '\0';
+        memset(&cli->disk, 0, sizeof(cli->disk));
+        cli->id = sessions_started;
+        cli->jslot = -1;
+        cli->unsynced = 0;
+        if (hio.qlog_dir) {
+            char path[512], peer[32];
+            snprintf(peer, sizeof(peer), "%s:%d", inet_ntoa(cli_addr->sin_addr),
+                     ntohs(cli_addr->sin_port));
+            snprintf(path, sizeof(path), "%s/server_%u_%s_%d.qlog", hio.qlog_dir, sessions_started,
+                     inet_ntoa(cli_addr->sin_addr), ntohs(cli_addr->sin_port));
+            cli->qlog = qlog_open(path, "server", peer);
+            qlog_event(cli->qlog, "connectivity:connection_started", "\"slot\":%d", idx);
+        }
+        sessions_started++;
+        TRACE3(session_new, idx, ntohl(cli_addr->sin_addr.s_addr), ntohs(cli_addr->sin_port));
+    }
+
+    PROF_BEGIN(PH_DISPATCH);
+    qlog_event(cli->qlog, "transport:packet_received", "\"type\":\"%s\",\"seq\":%d,\"len\":%d",
+               qlog_type_name(packet->type), packet->seq_num, n);
+    int fin = dispatch(idx, packet, n, cli_addr);
+    PROF_END(PH_DISPATCH);
+    return fin;
+}
+
+void flush_sessions(void) {
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        if (clients[i].active) qlog_flush(clients[i].qlog);
+    }
+}
+
+void checkpoint_sessions(void) {
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        if (clients[i].active) checkpoint(i);
+    }
+}
+
+// Las transferencias a medias quedan con lo recibido hasta acá
+void close_sessions(const char *reason) {
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        if (!clients[i].active) continue;
+        if (clients[i].fp) fclose(clients[i].fp);
+        clients[i].fp = NULL;
+        end_session(&clients[i], reason);
+    }
+}
+
+int save_sessions(session_rec_t *recs) {
+    int n = 0;
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        client_t *cli = &clients[i];
+        if (!cli->active) continue;
+        if (cli->fp) fflush(cli->fp);
+        session_rec_t *r = &recs[n++];
+        memset(r, 0, sizeof(*r));
+        r->slot = i;
+        r->addr = cli->addr;
+        r->state = cli->state;
+        r->expected_seq = cli->expected_seq;
+        r->bytes = cli->bytes;
+        memcpy(r->path, cli->path, sizeof(r->path));
+        r->disk = cli->disk;
+        r->id = cli->id;
+        r->jslot = cli->jslot;
+    }
+    return n;
+}
+
+int restore_session(const session_rec_t *r) {
+    if (r->slot < 0 || r->slot >= MAX_CLIENTS || r->state < STATE_NONE || r->state > STATE_DATA) {
+        return -1;
+    }
+    client_t *cli = &clients[r->slot];
+    memset(cli, 0, sizeof(*cli));
+    cli->addr = r->addr;
+    cli->state = r->state;
+    cli->expected_seq = r->expected_seq;
+    cli->bytes = r->bytes;
+    memcpy(cli->path, r->path, sizeof(cli->path));
+    cli->path[sizeof(cli->path) - 1] = '\0';
+    cli->disk = r->disk;
+    cli->id = r->id;
+    cli->jslot = -1;
+
+    // acá el cliente sigue mandando desde donde estaba: no se puede volver a 0
+    long offset = cli->bytes;
+    if (cli->state == STATE_DATA && (cli->fp = reopen_at(cli->path, &offset)) == NULL) {
+        return -1;
+    }
+    if (offset != cli->bytes) {
+        fclose(cli->fp);
+        cli->fp = NULL;
+        return -1;
+    }
+    cli->active = 1;
+    cli->jslot = journal_claim(r->jslot);
+    printf("Cliente %d: sesión retomada (%s, estado %s, %ld bytes)\n", r->slot,
+           cli->path[0] ? cli->path : "-", state_names[cli->state], cli->bytes);
+
+    if (hio.qlog_dir) {
+        char path[512], peer[32];
+        snprintf(peer, sizeof(peer), "%s:%d", inet_ntoa(cli->addr.sin_addr),
+                 ntohs(cli->addr.sin_port));
+        snprintf(path, sizeof(path), "%s/server_%u_%s_%d.qlog", hio.qlog_dir, sessions_started++,
+                 inet_ntoa(cli->addr.sin_addr), ntohs(cli->addr.sin_port));
+        cli->qlog = qlog_open(path, "server", peer);
+        qlog_event(cli->qlog, "connectivity:connection_started", "\"slot\":%d,\"handoff\":true,"
+                   "\"state\":\"%s\",\"offset\":%ld", r->slot, state_names[cli->state], cli->bytes);
+    }
+    return 0;
+}
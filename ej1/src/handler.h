@@ -0,0 +1,85 @@
+// handler.h
+// Máquina de estados del servidor: tabla de sesiones y tratamiento de cada
+// paquete ya recibido. server.c le pasa lo que lee del socket; handler_bench
+// le pasa buffers armados a mano y cambia los ACK y los archivos por
+// sumideros nulos (ver handler_io_t).
+#ifndef HANDLER_H
+#define HANDLER_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <netinet/in.h>
+#include "qlog.h"
+#include "disk_stats.h"
+
+#define MAX_CLIENTS 10
+
+// Estados del cliente
+typedef enum { STATE_NONE, STATE_AUTH, STATE_WRQ_DONE, STATE_DATA } client_state_t;
+
+typedef struct {
+    struct sockaddr_in addr;
+    int active;
+    client_state_t state;
+    FILE *fp;
+    uint8_t expected_seq;
+    qlog_t *qlog;       // traza de la sesión (-t), NULL si no se pidió
+    long bytes;         // bytes de DATA escritos
+    char path[50];      // archivo destino (WRQ)
+    disk_stats_t disk;  // latencia de disco de la sesión
+    unsigned id;        // número de sesión (trazas y diario)
+    int jslot;          // registro en el diario (-j), -1 si no hay
+    int unsynced;       // DATA escritos desde el último checkpoint
+} client_t;
+
+// Salidas del manejador. Los punteros en NULL son el comportamiento normal
+// del servidor (sendto y fopen); el benchmark los reemplaza.
+typedef struct {
+    int sockfd;
+    void (*send)(const void *buf, size_t len, const struct sockaddr_in *to);
+    FILE *(*open)(const char *path);
+    const char *qlog_dir;   // -t: trazas por sesión en este directorio
+    const char *disk_dir;   // -D: disk_latency.csv (en cada FIN) y disk_alerts.csv
+} handler_io_t;
+
+// Reinicio sin cortes (-u, ver handoff.h): lo que necesita el proceso nuevo
+// para seguir una sesión donde la dejó el viejo
+typedef struct {
+    int slot;
+    struct sockaddr_in addr;
+    int state;
+    uint8_t expected_seq;
+    long bytes;         // offset en el archivo destino
+    char path[50];
+    disk_stats_t disk;
+    unsigned id;
+    int jslot;
+} session_rec_t;
+
+extern client_t clients[MAX_CLIENTS];
+extern handler_io_t hio;
+extern disk_stats_t disk_total;
+extern uint64_t stall_us;   // -d: umbral de alerta de disco
+extern unsigned sessions_started;   // numera las trazas de -t
+extern int checkpoint_every;        // -j: DATA entre checkpoints del diario
+
+void init_clients(void);
+// Busca cliente por IP/Puerto o devuelve un slot libre (-1 si está lleno)
+int get_client_index(struct sockaddr_in *cli_addr);
+// Procesa un paquete de n bytes (n >= 2) de cli_addr; 1 si fue un FIN que
+// cerró la sesión
+int handle_packet(char *buffer, int n, struct sockaddr_in *cli_addr);
+// Manda a disco las trazas de las sesiones abiertas
+void flush_sessions(void);
+// Cierra archivos y trazas de todas las sesiones abiertas
+void close_sessions(const char *reason);
+// Checkpoint del diario de todas las subidas en curso (al detenerse)
+void checkpoint_sessions(void);
+// Foto de las sesiones abiertas (con los archivos ya en disco); devuelve
+// cuántas escribió en recs, que tiene lugar para MAX_CLIENTS
+int save_sessions(session_rec_t *recs);
+// Retoma una sesión de otro proceso reabriendo su archivo en el offset; -1
+// si no se pudo (la sesión se descarta y el cliente termina por timeout)
+int restore_session(const session_rec_t *r);
+
+#endif
@@ -0,0 +1,217 @@
+// handler_bench.c
+// Microbenchmark del procesamiento de paquetes del servidor, sin red: arma
+// buffers HELLO/WRQ/DATA/FIN y se los pasa directo a handle_packet(). Los ACK
+// van a una función que sólo los cuenta y los archivos a un FILE* que
+// descarta lo escrito, así que lo medido es la búsqueda de la sesión, la
+// máquina de estados y el fwrite en memoria, sin syscalls de por medio.
+//
+// Las sesiones avanzan intercaladas (DATA de la 0, de la 1, ...) como con
+// varios clientes a la vez. Se informa el mejor de -r repeticiones:
+//   ns/paq y Mpaq/s  todos los paquetes (HELLO, WRQ, DATA y FIN)
+//   ns/DATA          sólo la fase de datos
+//   ns lookup        get_client_index() solo, con las mismas direcciones
+//
+//   ./handler_bench [-s sesiones]... [-n paquetes] [-l bytes] [-r reps] [-o csv]
+#define _GNU_SOURCE   // fopencookie
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include "protocol.h"
+#include "handler.h"
+
+#define MAX_COUNTS 16
+
+static long acks;
+static long long sunk;
+
+static void null_send(const void *buf, size_t len, const struct sockaddr_in *to) {
+    (void)buf;
+    (void)len;
+    (void)to;
+    acks++;
+}
+
+static ssize_t null_write(void *cookie, const char *buf, size_t len) {
+    (void)cookie;
+    (void)buf;
+    sunk += (long long)len;
+    return (ssize_t)len;
+}
+
+static FILE *null_open(const char *path) {
+    (void)path;
+    cookie_io_functions_t io = { NULL, null_write, NULL, NULL };
+    return fopencookie(NULL, "w", io);
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static int make_pdu(char *buf, uint8_t type, uint8_t seq, const char *payload, int len) {
+    struct pdu *p = (struct pdu *)buf;
+    p->type = type;
+    p->seq_num = seq;
+    memcpy(p->payload, payload, (size_t)len);
+    return 2 + len;
+}
+
+typedef struct {
+    double total_ns, data_ns, lookup_ns;
+    long packets, data_packets;
+} bench_result_t;
+
+// Una pasada completa: S sesiones de n DATA cada una
+static int run_once(int nsess, long n, int len, bench_result_t *r) {
+    struct sockaddr_in addr[MAX_CLIENTS];
+    char buf[BUF_SIZE], data[MAX_PAYLOAD_SIZE], name[16];
+    memset(data, 'x', sizeof(data));
+    for (int s = 0; s < nsess; s++) {
+        memset(&addr[s], 0, sizeof(addr[s]));
+        addr[s].sin_family = AF_INET;
+        addr[s].sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr[s].sin_port = htons((uint16_t)(40000 + s));
+    }
+    init_clients();
+    acks = 0;
+    sunk = 0;
+
+    double t0 = now_ns();
+    for (int s = 0; s < nsess; s++) {
+        int k = make_pdu(buf, TYPE_HELLO, 0, "g21-0e29", 8);
+        handle_packet(buf, k, &addr[s]);
+        snprintf(name, sizeof(name), "bench%d", s);
+        k = make_pdu(buf, TYPE_WRQ, 1, name, (int)strlen(name));
+        handle_packet(buf, k, &addr[s]);
+    }
+    double t1 = now_ns();
+    for (long i = 0; i < n; i++) {
+        for (int s = 0; s < nsess; s++) {
+            int k = make_pdu(buf, TYPE_DATA, (uint8_t)(i & 1), data, len);
+            handle_packet(buf, k, &addr[s]);
+        }
+    }
+    double t2 = now_ns();
+
+    // sólo la búsqueda, con todas las sesiones todavía abiertas
+    volatile int sink = 0;
+    double t3 = now_ns();
+    for (long i = 0; i < n; i++) {
+        for (int s = 0; s < nsess; s++) sink += get_client_index(&addr[s]);
+    }
+    double t4 = now_ns();
+
+    for (int s = 0; s < nsess; s++) {
+        int k = make_pdu(buf, TYPE_FIN, (uint8_t)(n & 1), "", 0);
+        handle_packet(buf, k, &addr[s]);
+    }
+    double t5 = now_ns();
+
+    r->packets = (long)nsess * (n + 3);
+    r->data_packets = (long)nsess * n;
+    r->total_ns = (t2 - t0) + (t5 - t4);
+    r->data_ns = t2 - t1;
+    r->lookup_ns = t4 - t3;
+
+    // si algo no pasó por el camino feliz la medición no sirve
+    if (acks != r->packets || sunk != (long long)r->data_packets * len) {
+        fprintf(stderr, "ACK=%ld (esperados %ld), bytes=%lld (esperados %lld)\n", acks,
+                r->packets, sunk, (long long)r->data_packets * len);
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    int counts[MAX_COUNTS], n_counts = 0;
+    long n = 20000;
+    int len = MAX_PAYLOAD_SIZE, reps = 5;
+    const char *csv = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-s") == 0 && i + 1 < argc && n_counts < MAX_COUNTS) {
+            counts[n_counts++] = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            n = atol(argv[++i]);
+        } else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc) {
+            len = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            reps = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            csv = argv[++i];
+        } else {
+            fprintf(stderr, "Uso: %s [-s sesiones]... [-n paquetes] [-l bytes] [-r reps] [-o csv]\n"
+                    "  -s  sesiones simultáneas, 1..%d; repetible (1, 2, 5 y %d)\n"
+                    "  -n  paquetes DATA por sesión (20000)\n"
+                    "  -l  bytes de payload por DATA (%d)\n"
+                    "  -r  repeticiones, se informa la mejor (5)\n"
+                    "  -o  además, resultados en CSV\n", argv[0], MAX_CLIENTS, MAX_CLIENTS,
+                    MAX_PAYLOAD_SIZE);
+            return 1;
+        }
+    }
+    if (n_counts == 0) {
+        int def[] = { 1, 2, 5, MAX_CLIENTS };
+        for (int i = 0; i < 4; i++) counts[n_counts++] = def[i];
+    }
+    if (n < 1 || len < 1 || len > MAX_PAYLOAD_SIZE || reps < 1) {
+        fprintf(stderr, "Parámetros inválidos\n");
+        return 1;
+    }
+    for (int i = 0; i < n_counts; i++) {
+        if (counts[i] < 1 || counts[i] > MAX_CLIENTS) {
+            fprintf(stderr, "Sesiones entre 1 y %d\n", MAX_CLIENTS);
+            return 1;
+        }
+    }
+
+    // el manejador imprime una línea por HELLO/WRQ/FIN: stdout a /dev/null
+    // y los resultados por una copia del descriptor original
+    fflush(stdout);
+    FILE *out = fdopen(dup(STDOUT_FILENO), "w");
+    if (!out || !freopen("/dev/null", "w", stdout)) {
+        perror("stdout");
+        return 1;
+    }
+    hio.send = null_send;
+    hio.open = null_open;
+    stall_us = UINT64_MAX;   // sin alertas de disco
+
+    FILE *fp = NULL;
+    if (csv) {
+        fp = fopen(csv, "w");
+        if (!fp) {
+            perror(csv);
+            return 1;
+        }
+        fprintf(fp, "sessions,packets,payload,ns_per_packet,packets_per_s,ns_per_data,"
+                "ns_per_lookup\n");
+    }
+
+    fprintf(out, "%8s %10s %10s %10s %10s %10s\n", "sesiones", "paquetes", "ns/paq",
+            "Mpaq/s", "ns/DATA", "ns lookup");
+    for (int c = 0; c < n_counts; c++) {
+        bench_result_t best = { 0 }, r;
+        for (int k = 0; k < reps; k++) {
+            if (run_once(counts[c], n, len, &r) < 0) return 1;
+            if (k == 0 || r.total_ns < best.total_ns) best = r;
+        }
+        double ns = best.total_ns / (double)best.packets;
+        double ns_data = best.data_ns / (double)best.data_packets;
+        double ns_lookup = best.lookup_ns / (double)best.data_packets;
+        fprintf(out, "%8d %10ld %10.1f %10.3f %10.1f %10.1f\n", counts[c], best.packets, ns,
+                1e3 / ns, ns_data, ns_lookup);
+        if (fp) {
+            fprintf(fp, "%d,%ld,%d,%.1f,%.0f,%.1f,%.1f\n", counts[c], best.packets, len, ns,
+                    1e9 / ns, ns_data, ns_lookup);
+        }
+    }
+    if (fp) fclose(fp);
+    fclose(out);
+    return 0;
+}
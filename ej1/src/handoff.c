@@ -0,0 +1,199 @@
+// handoff.c
+#define _GNU_SOURCE   // accept4, SOCK_CLOEXEC
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include "handler.h"
+#include "handoff.h"
+
+#define HANDOFF_MAGIC   0x454a3148   // "EJ1H"
+#define HANDOFF_VERSION 2
+#define HANDOFF_WAIT_S  5            // espera máxima por la otra punta
+
+// Un solo mensaje SOCK_SEQPACKET: encabezado + registros, y el socket UDP
+// como dato auxiliar
+typedef struct {
+    uint32_t magic, version, rec_size, count;
+    uint32_t sessions;   // sessions_started, para no pisar trazas
+} handoff_hdr_t;
+
+typedef struct {
+    handoff_hdr_t hdr;
+    session_rec_t recs[MAX_CLIENTS];
+} handoff_msg_t;
+
+static int set_timeout(int fd) {
+    struct timeval tv = { HANDOFF_WAIT_S, 0 };
+    if (setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) < 0 ||
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv)) < 0) {
+        perror("handoff setsockopt");
+        return -1;
+    }
+    return 0;
+}
+
+static int fill_addr(struct sockaddr_un *addr, const char *path) {
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr->sun_path)) {
+        fprintf(stderr, "handoff: path demasiado largo: %s\n", path);
+        return -1;
+    }
+    strcpy(addr->sun_path, path);
+    return 0;
+}
+
+int handoff_listen(const char *path) {
+    struct sockaddr_un addr;
+    if (fill_addr(&addr, path) < 0) return -1;
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        perror("handoff socket");
+        return -1;
+    }
+    // si quedó de un proceso anterior, ya no hay nadie detrás
+    unlink(path);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, 1) < 0) {
+        perror("handoff bind");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int handoff_take(const char *path, int *udp_fd) {
+    struct sockaddr_un addr;
+    if (fill_addr(&addr, path) < 0) return -1;
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        perror("handoff socket");
+        return -1;
+    }
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        int err = errno;
+        close(fd);
+        if (err == ENOENT || err == ECONNREFUSED) return 0;
+        errno = err;
+        perror("handoff connect");
+        return -1;
+    }
+    if (set_timeout(fd) < 0) {
+        close(fd);
+        return -1;
+    }
+
+    handoff_msg_t msg;
+    union {
+        char buf[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    } ctl;
+    struct iovec iov = { &msg, sizeof(msg) };
+    struct msghdr mh;
+    memset(&mh, 0, sizeof(mh));
+    mh.msg_iov = &iov;
+    mh.msg_iovlen = 1;
+    mh.msg_control = ctl.buf;
+    mh.msg_controllen = sizeof(ctl.buf);
+
+    ssize_t n = recvmsg(fd, &mh, MSG_CMSG_CLOEXEC);
+    struct cmsghdr *cm = n > 0 ? CMSG_FIRSTHDR(&mh) : NULL;
+    int sock = -1;
+    if (cm && cm->cmsg_level == SOL_SOCKET && cm->cmsg_type == SCM_RIGHTS) {
+        memcpy(&sock, CMSG_DATA(cm), sizeof(int));
+    }
+    char ok = 0;
+    if (n < 0) {
+        perror("handoff recvmsg");
+    } else if (sock < 0 || (mh.msg_flags & (MSG_TRUNC | MSG_CTRUNC)) ||
+               (size_t)n < sizeof(msg.hdr) || msg.hdr.magic != HANDOFF_MAGIC) {
+        fprintf(stderr, "handoff: mensaje inválido de %s\n", path);
+    } else if (msg.hdr.version != HANDOFF_VERSION || msg.hdr.rec_size != sizeof(session_rec_t) ||
+               msg.hdr.count > MAX_CLIENTS ||
+               (size_t)n != sizeof(msg.hdr) + msg.hdr.count * sizeof(session_rec_t)) {
+        // otro formato de sesión: que el viejo siga atendiendo
+        fprintf(stderr, "handoff: formato incompatible (versión %u, registro de %u bytes)\n",
+                msg.hdr.version, msg.hdr.rec_size);
+    } else {
+        ok = 1;
+    }
+    if (!ok) {
+        send(fd, &ok, 1, MSG_NOSIGNAL);
+        if (sock >= 0) close(sock);
+        close(fd);
+        return -1;
+    }
+
+    init_clients();
+    sessions_started = msg.hdr.sessions;
+    int restored = 0;
+    for (uint32_t i = 0; i < msg.hdr.count; i++) {
+        restored += restore_session(&msg.recs[i]) == 0;
+    }
+
+    // desde el ACK el viejo deja de leer el socket UDP
+    if (send(fd, &ok, 1, MSG_NOSIGNAL) != 1) {
+        perror("handoff send");
+        close_sessions("handoff_failed");
+        close(sock);
+        close(fd);
+        return -1;
+    }
+    close(fd);
+    printf("Relevo tomado de %s: %d de %u sesiones retomadas.\n", path, restored, msg.hdr.count);
+    *udp_fd = sock;
+    return 1;
+}
+
+int handoff_give(int listen_fd, int udp_fd) {
+    int fd = accept4(listen_fd, NULL, NULL, SOCK_CLOEXEC);
+    if (fd < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) perror("handoff accept");
+        return 0;
+    }
+    if (set_timeout(fd) < 0) {
+        close(fd);
+        return 0;
+    }
+
+    handoff_msg_t msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.hdr.magic = HANDOFF_MAGIC;
+    msg.hdr.version = HANDOFF_VERSION;
+    msg.hdr.rec_size = sizeof(session_rec_t);
+    msg.hdr.count = (uint32_t)save_sessions(msg.recs);
+    msg.hdr.sessions = sessions_started;
+
+    union {
+        char buf[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    } ctl;
+    memset(&ctl, 0, sizeof(ctl));
+    struct iovec iov = { &msg, sizeof(msg.hdr) + msg.hdr.count * sizeof(session_rec_t) };
+    struct msghdr mh;
+    memset(&mh, 0, sizeof(mh));
+    mh.msg_iov = &iov;
+    mh.msg_iovlen = 1;
+    mh.msg_control = ctl.buf;
+    mh.msg_controllen = sizeof(ctl.buf);
+    struct cmsghdr *cm = CMSG_FIRSTHDR(&mh);
+    cm->cmsg_level = SOL_SOCKET;
+    cm->cmsg_type = SCM_RIGHTS;
+    cm->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cm), &udp_fd, sizeof(int));
+
+    char ok = 0;
+    if (sendmsg(fd, &mh, MSG_NOSIGNAL) < 0) {
+        perror("handoff sendmsg");
+    } else if (recv(fd, &ok, 1, 0) != 1 || !ok) {
+        fprintf(stderr, "handoff: el proceso nuevo no tomó el relevo, se sigue atendiendo\n");
+        ok = 0;
+    }
+    close(fd);
+    if (ok) printf("Relevo entregado: %u sesiones traspasadas.\n", msg.hdr.count);
+    return ok;
+}
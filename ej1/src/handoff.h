@@ -0,0 +1,21 @@
+// handoff.h
+// Reinicio sin cortes del servidor (-u path). El proceso en marcha escucha
+// en un socket UNIX; uno nuevo que arranca con el mismo path se conecta y
+// recibe el socket UDP ya ligado (SCM_RIGHTS) junto con la foto de las
+// sesiones abiertas. Los paquetes que llegan durante el traspaso esperan en
+// la cola del socket, que es el mismo en los dos procesos, así que las
+// transferencias siguen sin perder nada y el viejo termina.
+#ifndef HANDOFF_H
+#define HANDOFF_H
+
+// Socket de escucha (no bloqueante) en path; -1 si falla
+int handoff_listen(const char *path);
+// Lado nuevo: pide el relevo al servidor de path. 1 si lo tomó (*udp_fd
+// queda con el socket y las sesiones restauradas), 0 si no había nadie
+// escuchando, -1 si falló a mitad de camino
+int handoff_take(const char *path, int *udp_fd);
+// Lado viejo, cuando listen_fd tiene una conexión: 1 si el proceso nuevo
+// aceptó las sesiones (hay que cerrarlas y salir), 0 si hay que seguir
+int handoff_give(int listen_fd, int udp_fd);
+
+#endif
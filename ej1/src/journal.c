@@ -0,0 +1,152 @@
+// journal.c
+#define _POSIX_C_SOURCE 200809L   // ftruncate
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <arpa/inet.h>
+#include "journal.h"
+
+#define JOURNAL_MAGIC   0x454a314a   // "EJ1J"
+#define JOURNAL_VERSION 1
+
+typedef struct {
+    uint32_t magic, version, slots, rec_size;
+} journal_hdr_t;
+
+// Dos copias por registro y se pisa siempre la más vieja: si el proceso
+// muere a mitad de una escritura queda la otra entera
+typedef struct {
+    journal_hdr_t hdr;
+    journal_rec_t rec[JOURNAL_SLOTS][2];
+} journal_map_t;
+
+static journal_map_t *jm;
+static char owned[JOURNAL_SLOTS];   // registros de sesiones de este proceso
+
+static uint32_t rec_sum(const journal_rec_t *r) {
+    const unsigned char *p = (const unsigned char *)r + sizeof(r->sum);
+    uint32_t h = 2166136261u;
+    for (size_t i = sizeof(r->sum); i < sizeof(*r); i++) h = (h ^ *p++) * 16777619u;
+    return h;
+}
+
+// Copia vigente del registro, NULL si ninguna de las dos está sana
+static const journal_rec_t *current(int slot) {
+    const journal_rec_t *a = &jm->rec[slot][0], *b = &jm->rec[slot][1];
+    int ok_a = a->gen && a->sum == rec_sum(a), ok_b = b->gen && b->sum == rec_sum(b);
+    if (ok_a && ok_b) return a->gen > b->gen ? a : b;
+    return ok_a ? a : ok_b ? b : NULL;
+}
+
+static int pending(int slot) {
+    const journal_rec_t *r = current(slot);
+    return !owned[slot] && r && r->active;
+}
+
+int journal_open(const char *path) {
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0 || ftruncate(fd, sizeof(journal_map_t)) < 0) {
+        perror(path);
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    jm = mmap(NULL, sizeof(journal_map_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (jm == MAP_FAILED) {
+        perror("journal mmap");
+        jm = NULL;
+        return -1;
+    }
+    if (jm->hdr.magic != JOURNAL_MAGIC || jm->hdr.version != JOURNAL_VERSION ||
+        jm->hdr.slots != JOURNAL_SLOTS || jm->hdr.rec_size != sizeof(journal_rec_t)) {
+        if (jm->hdr.magic) fprintf(stderr, "%s: diario de otro formato, se reinicia\n", path);
+        memset(jm, 0, sizeof(*jm));
+        jm->hdr = (journal_hdr_t){ JOURNAL_MAGIC, JOURNAL_VERSION, JOURNAL_SLOTS,
+                                   sizeof(journal_rec_t) };
+    }
+
+    for (int i = 0; i < JOURNAL_SLOTS; i++) {
+        if (!pending(i)) continue;
+        const journal_rec_t *r = current(i);
+        struct in_addr ip = { r->ip };
+        printf("Diario: sesión %u (%s de %s) reanudable desde el byte %lld\n", r->id, r->path,
+               inet_ntoa(ip), (long long)r->offset);
+    }
+    return 0;
+}
+
+int journal_alloc(void) {
+    if (!jm) return -1;
+    int oldest = -1;
+    int64_t oldest_t = 0;
+    for (int i = 0; i < JOURNAL_SLOTS; i++) {
+        if (owned[i]) continue;
+        const journal_rec_t *r = current(i);
+        if (!r || !r->active) {
+            owned[i] = 1;
+            return i;
+        }
+        if (oldest < 0 || r->t_s < oldest_t) {
+            oldest = i;
+            oldest_t = r->t_s;
+        }
+    }
+    if (oldest >= 0) owned[oldest] = 1;
+    return oldest;
+}
+
+int journal_claim(int slot) {
+    if (!jm || slot < 0 || slot >= JOURNAL_SLOTS) return -1;
+    owned[slot] = 1;
+    return slot;
+}
+
+void journal_write(int slot, const journal_rec_t *r) {
+    if (!jm || slot < 0 || slot >= JOURNAL_SLOTS) return;
+    const journal_rec_t *cur = current(slot);
+    journal_rec_t *dst = cur == &jm->rec[slot][0] ? &jm->rec[slot][1] : &jm->rec[slot][0];
+    journal_rec_t tmp = *r;
+    tmp.gen = cur ? cur->gen + 1 : 1;
+    tmp.t_s = (int64_t)time(NULL);
+    tmp.sum = rec_sum(&tmp);
+    // la página es compartida: sobrevive a la caída del proceso; el kernel
+    // la baja a disco por su cuenta (después del fdatasync de los datos)
+    *dst = tmp;
+}
+
+void journal_release(int slot) {
+    if (!jm || slot < 0 || slot >= JOURNAL_SLOTS) return;
+    journal_rec_t r;
+    memset(&r, 0, sizeof(r));
+    journal_write(slot, &r);
+    owned[slot] = 0;
+}
+
+int journal_find(uint32_t ip, const char *path, journal_rec_t *out) {
+    if (!jm) return -1;
+    int best = -1;
+    for (int i = 0; i < JOURNAL_SLOTS; i++) {
+        if (!pending(i)) continue;
+        const journal_rec_t *r = current(i);
+        if (r->ip != ip || strncmp(r->path, path, sizeof(r->path)) != 0) continue;
+        if (best < 0 || r->t_s > current(best)->t_s) best = i;   // el más reciente
+    }
+    if (best >= 0) *out = *current(best);
+    return best;
+}
+
+int journal_forget(uint32_t ip, const char *path) {
+    if (!jm) return 0;
+    int n = 0;
+    for (int i = 0; i < JOURNAL_SLOTS; i++) {
+        if (!pending(i)) continue;
+        const journal_rec_t *r = current(i);
+        if (r->ip != ip || strncmp(r->path, path, sizeof(r->path)) != 0) continue;
+        journal_release(i);
+        n++;
+    }
+    return n;
+}
@@ -0,0 +1,49 @@
+// journal.h
+// Diario de sesiones a prueba de caídas (-j). Es un archivo chico mapeado
+// en memoria con un registro por subida en curso: archivo, IP del cliente,
+// offset confirmado y secuencia. El servidor lo actualiza en checkpoints
+// cada tantos DATA: primero fdatasync del archivo y recién después el
+// offset, así que el diario nunca promete más de lo que hay en disco.
+//
+// Si el proceso muere, al arrancar con el mismo -j los registros activos
+// quedan pendientes; un cliente que vuelve con -r y el mismo nombre remoto
+// recibe el offset en el ACK del WRQ y sigue desde ahí.
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stdint.h>
+
+#define JOURNAL_SLOTS 64
+
+typedef struct {
+    uint32_t sum;           // FNV-1a del resto; distinto => copia rota
+    uint32_t gen;           // la copia válida con gen mayor es la vigente
+    uint32_t active;
+    uint32_t id;            // número de sesión (el mismo de las trazas)
+    uint32_t ip;            // orden de red
+    uint16_t port;
+    uint8_t state, expected_seq;
+    int64_t offset;         // bytes ya en disco
+    int64_t t_s;            // hora del checkpoint
+    char path[56];          // sin relleno: el checksum cubre todo el registro
+} journal_rec_t;
+
+// Mapea (o crea) el diario; -1 si no se pudo. Sin diario abierto el resto
+// de las funciones no hace nada.
+int  journal_open(const char *path);
+// Registro libre para una sesión nueva; -1 si no hay diario. Con todo
+// ocupado se reusa el pendiente más viejo.
+int  journal_alloc(void);
+// Marca como propio un registro que viene de un traspaso (-u) o de -r;
+// devuelve el mismo slot, o -1 si no hay diario
+int  journal_claim(int slot);
+void journal_write(int slot, const journal_rec_t *r);
+// Libera el registro al terminar la subida
+void journal_release(int slot);
+// Registro pendiente (sin dueño) de ese archivo e IP; -1 si no hay
+int  journal_find(uint32_t ip, const char *path, journal_rec_t *out);
+// Libera todos los pendientes de ese archivo e IP (el archivo se vuelve a
+// escribir de cero o ya se retomó); devuelve cuántos
+int  journal_forget(uint32_t ip, const char *path);
+
+#endif
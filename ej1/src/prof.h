@@ -0,0 +1,138 @@
+// prof.h
+// Instrumentación opcional del camino caliente del servidor. Compilando con
+// -DSERVER_PROFILE (make server_prof) cada fase se mide con rdtsc (o
+// clock_gettime fuera de x86) en un histograma log2, que se vuelca a stderr
+// con `kill -USR1 <pid>`. Sin el define las macros no generan código.
+#ifndef PROF_H
+#define PROF_H
+
+enum { PH_RECV, PH_LOOKUP, PH_DISPATCH, PH_FWRITE, PH_SEND_ACK, PH_COUNT };
+
+#ifdef SERVER_PROFILE
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define PROF_TSC 1
+static inline uint64_t prof_now(void) { return __rdtsc(); }
+#else
+static inline uint64_t prof_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+#endif
+
+#define PROF_BUCKETS 64   // bucket b: duraciones en [2^(b-1), 2^b) ticks
+
+typedef struct {
+    uint64_t start;       // 0 => fase cerrada
+    uint64_t count, sum, max;
+    uint64_t buckets[PROF_BUCKETS];
+} prof_phase_t;
+
+// Definidos en handler.c: server.c y handler.c comparten los contadores
+extern prof_phase_t prof_phases[PH_COUNT];
+static const char *const prof_names[PH_COUNT] = {
+    "recvfrom", "get_client_index", "dispatch", "fwrite", "send_ack"
+};
+extern double prof_ns_per_tick;
+extern volatile sig_atomic_t prof_dump_requested;
+
+static void prof_on_signal(int sig) {
+    (void)sig;
+    prof_dump_requested = 1;
+}
+
+static inline void prof_init(void) {
+#ifdef PROF_TSC
+    // calibrar el TSC contra el reloj monotónico
+    struct timespec a, b, d = { 0, 50000000 };
+    clock_gettime(CLOCK_MONOTONIC, &a);
+    uint64_t t0 = prof_now();
+    nanosleep(&d, NULL);
+    uint64_t t1 = prof_now();
+    clock_gettime(CLOCK_MONOTONIC, &b);
+    double ns = (double)(b.tv_sec - a.tv_sec) * 1e9 + (double)(b.tv_nsec - a.tv_nsec);
+    prof_ns_per_tick = ns / (double)(t1 - t0);
+#endif
+    // sin SA_RESTART: pselect() vuelve con EINTR y el volcado sale enseguida
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = prof_on_signal;
+    sigaction(SIGUSR1, &sa, NULL);
+    fprintf(stderr, "Perfilado activo (%.3f ns/tick); kill -USR1 %d para volcar\n",
+            prof_ns_per_tick, (int)getpid());
+}
+
+static inline void prof_begin(int ph) { prof_phases[ph].start = prof_now(); }
+
+static inline void prof_end(int ph) {
+    prof_phase_t *p = &prof_phases[ph];
+    uint64_t d = prof_now() - p->start;
+    p->start = 0;
+    // TSC de otro core un poco atrasado: la resta da la vuelta, se descarta
+    if ((int64_t)d < 0) return;
+    int b = d ? 64 - __builtin_clzll(d) : 0;
+    if (b >= PROF_BUCKETS) b = PROF_BUCKETS - 1;
+    p->count++;
+    p->sum += d;
+    if (d > p->max) p->max = d;
+    p->buckets[b]++;
+}
+
+// Cierra la fase si quedó abierta (p.ej. por un `continue` a mitad de camino)
+static inline void prof_end_open(int ph) {
+    if (prof_phases[ph].start) prof_end(ph);
+}
+
+// Percentil aproximado: cota superior del bucket que lo contiene, en ns
+static inline double prof_percentile(const prof_phase_t *p, double pct) {
+    uint64_t target = (uint64_t)((double)p->count * pct / 100.0), seen = 0;
+    for (int b = 0; b < PROF_BUCKETS; b++) {
+        seen += p->buckets[b];
+        if (seen > target) return (double)(b ? 1ULL << b : 1) * prof_ns_per_tick;
+    }
+    return (double)p->max * prof_ns_per_tick;
+}
+
+static inline void prof_dump(void) {
+    prof_dump_requested = 0;
+    fprintf(stderr, "%-18s %10s %10s %10s %10s %10s %14s\n", "fase", "n", "avg_ns",
+            "p50_ns", "p99_ns", "max_ns", "total_ms");
+    for (int i = 0; i < PH_COUNT; i++) {
+        const prof_phase_t *p = &prof_phases[i];
+        if (p->count == 0) continue;
+        fprintf(stderr, "%-18s %10llu %10.0f %10.0f %10.0f %10.0f %14.3f\n", prof_names[i],
+                (unsigned long long)p->count,
+                (double)p->sum / (double)p->count * prof_ns_per_tick,
+                prof_percentile(p, 50), prof_percentile(p, 99),
+                (double)p->max * prof_ns_per_tick,
+                (double)p->sum * prof_ns_per_tick / 1e6);
+    }
+}
+
+#define PROF_INIT()        prof_init()
+#define PROF_BEGIN(ph)     prof_begin(ph)
+#define PROF_END(ph)       prof_end(ph)
+#define PROF_END_OPEN(ph)  prof_end_open(ph)
+#define PROF_CANCEL(ph)    (prof_phases[ph].start = 0)
+#define PROF_POLL()        do { if (prof_dump_requested) prof_dump(); } while (0)
+
+#else
+
+#define PROF_INIT()        ((void)0)
+#define PROF_BEGIN(ph)     ((void)0)
+#define PROF_END(ph)       ((void)0)
+#define PROF_END_OPEN(ph)  ((void)0)
+#define PROF_CANCEL(ph)    ((void)0)
+#define PROF_POLL()        ((void)0)
+
+#endif
+#endif
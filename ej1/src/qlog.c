@@ -0,0 +1,167 @@
+// qlog.c
+#define _POSIX_C_SOURCE 200809L   // clock_gettime
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+#include <pthread.h>
+#include "protocol.h"
+#include "qlog.h"
+
+#define QLOG_CHUNK (32 * 1024)   // se entrega al escritor al pasar este tamaño
+#define QLOG_LINE  512           // evento más largo que se admite
+
+// Bloque pendiente de escritura; `last` => cerrar el archivo después
+typedef struct qlog_chunk {
+    FILE *fp;
+    char *buf;
+    size_t len;
+    int last;
+    struct qlog_chunk *next;
+} qlog_chunk_t;
+
+struct qlog {
+    FILE *fp;
+    char *buf;
+    size_t used;
+    struct timespec t0;
+};
+
+static pthread_mutex_t q_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  q_cond = PTHREAD_COND_INITIALIZER;
+static qlog_chunk_t *q_head, *q_tail;
+static pthread_t q_thread;
+static int q_started, q_stop;
+
+static void *writer_thread(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&q_lock);
+    for (;;) {
+        while (!q_head && !q_stop) pthread_cond_wait(&q_cond, &q_lock);
+        if (!q_head) break;   // q_stop y la cola vacía
+        qlog_chunk_t *c = q_head;
+        q_head = c->next;
+        if (!q_head) q_tail = NULL;
+        pthread_mutex_unlock(&q_lock);
+
+        if (c->len > 0) fwrite(c->buf, 1, c->len, c->fp);
+        if (c->last) fclose(c->fp);
+        else fflush(c->fp);
+        free(c->buf);
+        free(c);
+
+        pthread_mutex_lock(&q_lock);
+    }
+    pthread_mutex_unlock(&q_lock);
+    return NULL;
+}
+
+static void submit(qlog_t *q, int last) {
+    qlog_chunk_t *c = malloc(sizeof(*c));
+    if (!c) {   // sin memoria: se pierde lo acumulado, no la sesión
+        q->used = 0;
+        return;
+    }
+    c->fp = q->fp;
+    c->buf = q->buf;
+    c->len = q->used;
+    c->last = last;
+    c->next = NULL;
+
+    pthread_mutex_lock(&q_lock);
+    if (q_tail) q_tail->next = c;
+    else q_head = c;
+    q_tail = c;
+    pthread_cond_signal(&q_cond);
+    pthread_mutex_unlock(&q_lock);
+
+    q->buf = last ? NULL : malloc(QLOG_CHUNK + QLOG_LINE);
+    q->used = 0;
+}
+
+qlog_t *qlog_open(const char *path, const char *vantage, const char *peer) {
+    if (!q_started) {
+        if (pthread_create(&q_thread, NULL, writer_thread, NULL) != 0) {
+            perror("qlog pthread_create");
+            return NULL;
+        }
+        q_started = 1;
+    }
+
+    qlog_t *q = calloc(1, sizeof(*q));
+    if (!q) return NULL;
+    q->fp = fopen(path, "w");
+    q->buf = malloc(QLOG_CHUNK + QLOG_LINE);
+    if (!q->fp || !q->buf) {
+        perror("qlog fopen");
+        if (q->fp) fclose(q->fp);
+        free(q->buf);
+        free(q);
+        return NULL;
+    }
+
+    struct timespec wall;
+    clock_gettime(CLOCK_MONOTONIC, &q->t0);
+    clock_gettime(CLOCK_REALTIME, &wall);
+    q->used = (size_t)snprintf(q->buf, QLOG_LINE,
+        "{\"qlog_format\":\"JSON-SEQ\",\"qlog_version\":\"0.3\",\"title\":\"ej1\","
+        "\"vantage_point\":\"%s\",\"peer\":\"%s\",\"time_format\":\"relative\","
+        "\"reference_time\":%.3f}\n",
+        vantage, peer, (double)wall.tv_sec * 1e3 + (double)wall.tv_nsec / 1e6);
+    return q;
+}
+
+void qlog_event(qlog_t *q, const char *name, const char *fmt, ...) {
+    if (!q || !q->buf) return;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double t = (double)(now.tv_sec - q->t0.tv_sec) * 1e3 +
+               (double)(now.tv_nsec - q->t0.tv_nsec) / 1e6;
+
+    char *p = q->buf + q->used;
+    size_t room = QLOG_LINE - 3;   // lugar para "}}\n"
+    int n = snprintf(p, room, "{\"time\":%.3f,\"name\":\"%s\",\"data\":{", t, name);
+    if (n < 0 || (size_t)n >= room) return;
+    va_list ap;
+    va_start(ap, fmt);
+    int m = vsnprintf(p + n, room - (size_t)n, fmt, ap);
+    va_end(ap);
+    if (m < 0 || (size_t)(n + m) >= room) return;   // evento truncado: se descarta
+    memcpy(p + n + m, "}}\n", 3);
+    q->used += (size_t)(n + m) + 3;
+
+    if (q->used >= QLOG_CHUNK) submit(q, 0);
+}
+
+void qlog_flush(qlog_t *q) {
+    if (q && q->buf && q->used > 0) submit(q, 0);
+}
+
+void qlog_close(qlog_t *q) {
+    if (!q) return;
+    submit(q, 1);   // con buf NULL sólo cierra el archivo
+    free(q);
+}
+
+void qlog_shutdown(void) {
+    if (!q_started) return;
+    pthread_mutex_lock(&q_lock);
+    q_stop = 1;
+    pthread_cond_signal(&q_cond);
+    pthread_mutex_unlock(&q_lock);
+    pthread_join(q_thread, NULL);
+    q_started = 0;
+    q_stop = 0;
+}
+
+const char *qlog_type_name(int type) {
+    switch (type) {
+    case TYPE_HELLO: return "HELLO";
+    case TYPE_WRQ:   return "WRQ";
+    case TYPE_DATA:  return "DATA";
+    case TYPE_ACK:   return "ACK";
+    case TYPE_FIN:   return "FIN";
+    default:         return "UNKNOWN";
+    }
+}
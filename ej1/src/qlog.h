@@ -0,0 +1,31 @@
+// qlog.h
+// Traza estructurada de eventos por sesión, al estilo qlog: un archivo JSON
+// por línea con una cabecera y después un evento por línea:
+//
+//   {"qlog_format":"JSON-SEQ","vantage_point":"server","title":"ej1",...}
+//   {"time":1.234,"name":"transport:packet_received","data":{"type":"DATA",...}}
+//
+// "time" son ms desde que se abrió la sesión y "reference_time" (cabecera) es
+// ese instante en ms de época, para poder alinear la traza del cliente con la
+// del servidor (qlog_view). Los eventos se arman en un buffer en memoria por
+// sesión y un hilo aparte es el que escribe a disco, así el camino de los
+// paquetes nunca espera por el archivo.
+#ifndef QLOG_H
+#define QLOG_H
+
+typedef struct qlog qlog_t;
+
+// NULL si no se pudo abrir (se avisa por stderr y la sesión sigue sin traza)
+qlog_t *qlog_open(const char *path, const char *vantage, const char *peer);
+// `fmt` arma el contenido del objeto "data" (sin las llaves)
+void qlog_event(qlog_t *q, const char *name, const char *fmt, ...)
+    __attribute__((format(printf, 3, 4)));
+// Manda lo acumulado al hilo escritor sin cerrar la sesión
+void qlog_flush(qlog_t *q);
+void qlog_close(qlog_t *q);
+// Espera a que el hilo escritor vacíe la cola (al salir del proceso)
+void qlog_shutdown(void);
+
+const char *qlog_type_name(int type);
+
+#endif
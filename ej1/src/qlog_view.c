@@ -0,0 +1,261 @@
+// qlog_view.c
+// Línea de tiempo de una o más trazas .qlog (client -t / server -t). Las
+// trazas se alinean por su reference_time y se muestran en dos columnas,
+// cliente a la izquierda y servidor a la derecha, marcando los huecos largos
+// sin eventos. Al final, un resumen por traza.
+//
+//   ./qlog_view [-g ms] [-v] [-s] cliente.qlog traces/server_0_*.qlog
+#define _POSIX_C_SOURCE 200809L   // strdup
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_FILES 16
+#define LINE_LEN  1024
+#define COL_WIDTH 46
+
+typedef struct {
+    double abs_ms;      // reference_time + time
+    int file;
+    long order;         // desempate estable
+    char *line;
+} event_t;
+
+typedef struct {
+    const char *path;
+    char vantage[16];
+    double ref_ms;
+    long events, sent, received, retransmits, timeouts, duplicates;
+    long rtt_n;
+    double rtt_min, rtt_max, rtt_sum;
+    double first_ms, last_ms;
+} trace_t;
+
+static trace_t traces[MAX_FILES];
+static int ntraces;
+static event_t *events;
+static long nevents, cap_events;
+
+// Valor de "key" como número; -1 si no está
+static int json_num(const char *line, const char *key, double *out) {
+    char pat[64];
+    snprintf(pat, sizeof(pat), "\"%s\":", key);
+    const char *p = strstr(line, pat);
+    if (!p) return -1;
+    char *end;
+    *out = strtod(p + strlen(pat), &end);
+    return end == p + strlen(pat) ? -1 : 0;
+}
+
+// Valor de "key" como string (sin escapes: la traza no los genera)
+static int json_str(const char *line, const char *key, char *out, size_t len) {
+    char pat[64];
+    snprintf(pat, sizeof(pat), "\"%s\":\"", key);
+    const char *p = strstr(line, pat);
+    if (!p) return -1;
+    p += strlen(pat);
+    size_t i = 0;
+    while (*p && *p != '"' && i + 1 < len) out[i++] = *p++;
+    out[i] = '\0';
+    return 0;
+}
+
+static int load_trace(const char *path) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        perror(path);
+        return -1;
+    }
+    trace_t *t = &traces[ntraces];
+    memset(t, 0, sizeof(*t));
+    t->path = path;
+
+    char line[LINE_LEN];
+    int header = 0;
+    while (fgets(line, sizeof(line), fp)) {
+        if (!header) {
+            if (json_str(line, "vantage_point", t->vantage, sizeof(t->vantage)) < 0 ||
+                json_num(line, "reference_time", &t->ref_ms) < 0) {
+                fprintf(stderr, "%s: no es una traza qlog de ej1\n", path);
+                fclose(fp);
+                return -1;
+            }
+            header = 1;
+            continue;
+        }
+        double time;
+        if (json_num(line, "time", &time) < 0) continue;
+        if (nevents == cap_events) {
+            cap_events = cap_events ? cap_events * 2 : 4096;
+            events = realloc(events, (size_t)cap_events * sizeof(*events));
+            if (!events) {
+                perror("realloc");
+                exit(EXIT_FAILURE);
+            }
+        }
+        event_t *e = &events[nevents];
+        e->abs_ms = t->ref_ms + time;
+        e->file = ntraces;
+        e->order = nevents++;
+        e->line = strdup(line);
+        if (t->events++ == 0) t->first_ms = time;
+        t->last_ms = time;
+    }
+    fclose(fp);
+    if (!header) {
+        fprintf(stderr, "%s: traza vacía, se ignora\n", path);
+        return 0;
+    }
+    ntraces++;
+    return 0;
+}
+
+static int cmp_event(const void *a, const void *b) {
+    const event_t *x = a, *y = b;
+    if (x->abs_ms != y->abs_ms) return x->abs_ms < y->abs_ms ? -1 : 1;
+    return x->order < y->order ? -1 : (x->order > y->order);
+}
+
+// Texto corto del evento; 0 si no se muestra (detalle sólo con -v)
+static int describe(const char *line, trace_t *t, int verbose, char *out, size_t len) {
+    char name[64], type[16], s[32];
+    double seq = 0, n = 0, v = 0;
+    json_str(line, "name", name, sizeof(name));
+    json_str(line, "type", type, sizeof(type));
+    json_num(line, "seq", &seq);
+    json_num(line, "len", &n);
+
+    if (strcmp(name, "transport:packet_sent") == 0) {
+        int rtx = strstr(line, "\"retransmit\":true") != NULL;
+        t->sent++;
+        t->retransmits += rtx;
+        snprintf(out, len, "%s#%d (%d) -->%s", type, (int)seq, (int)n, rtx ? " RTX" : "");
+    } else if (strcmp(name, "transport:packet_received") == 0) {
+        t->received++;
+        snprintf(out, len, "--> %s#%d (%d)", type, (int)seq, (int)n);
+    } else if (strcmp(name, "transport:packet_dropped") == 0) {
+        t->duplicates++;
+        snprintf(out, len, "duplicado %s#%d", type, (int)seq);
+    } else if (strcmp(name, "recovery:metrics_updated") == 0) {
+        if (json_num(line, "latest_rtt", &v) == 0) {
+            double srtt = 0;
+            json_num(line, "smoothed_rtt", &srtt);
+            if (t->rtt_n == 0 || v < t->rtt_min) t->rtt_min = v;
+            if (t->rtt_n == 0 || v > t->rtt_max) t->rtt_max = v;
+            t->rtt_sum += v;
+            t->rtt_n++;
+            if (!verbose) return 0;
+            snprintf(out, len, "rtt=%.3f srtt=%.3f ms", v, srtt);
+        } else {
+            if (!verbose) return 0;
+            json_num(line, "bytes_in_flight", &v);
+            snprintf(out, len, "en vuelo=%d", (int)v);
+        }
+    } else if (strcmp(name, "recovery:loss_timer_updated") == 0) {
+        json_str(line, "event_type", s, sizeof(s));
+        if (strcmp(s, "expired") == 0) {
+            t->timeouts++;
+            snprintf(out, len, "** TIMEOUT **");
+        } else {
+            if (!verbose) return 0;
+            snprintf(out, len, "timer %s", s);
+        }
+    } else if (strcmp(name, "transport:state_updated") == 0) {
+        char old[16] = "";
+        json_str(line, "old", old, sizeof(old));
+        json_str(line, "new", s, sizeof(s));
+        snprintf(out, len, "estado %s%s%s", old, old[0] ? " -> " : "", s);
+    } else if (strcmp(name, "transport:data_moved") == 0) {
+        if (!verbose) return 0;
+        json_num(line, "offset", &v);
+        snprintf(out, len, "disco @%ld +%d", (long)v, (int)n);
+    } else if (strcmp(name, "connectivity:connection_started") == 0) {
+        snprintf(out, len, "== inicio de sesión");
+    } else if (strcmp(name, "connectivity:connection_closed") == 0) {
+        json_str(line, "reason", s, sizeof(s));
+        snprintf(out, len, "== fin (%s)", s);
+    } else {
+        snprintf(out, len, "%s", name);
+    }
+    return 1;
+}
+
+static void print_summary(const trace_t *t) {
+    printf("%s [%s]: %ld eventos en %.3f ms, enviados=%ld recibidos=%ld"
+           " retransmisiones=%ld timeouts=%ld duplicados=%ld",
+           t->path, t->vantage, t->events, t->last_ms - t->first_ms, t->sent,
+           t->received, t->retransmits, t->timeouts, t->duplicates);
+    if (t->rtt_n > 0) {
+        printf(" rtt min/avg/max=%.3f/%.3f/%.3f ms", t->rtt_min, t->rtt_sum / t->rtt_n,
+               t->rtt_max);
+    }
+    printf("\n");
+}
+
+int main(int argc, char *argv[]) {
+    double gap_ms = 100;
+    int verbose = 0, summary_only = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-g") == 0 && i + 1 < argc) {
+            gap_ms = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-v") == 0) {
+            verbose = 1;
+        } else if (strcmp(argv[i], "-s") == 0) {
+            summary_only = 1;
+        } else if (argv[i][0] == '-') {
+            ntraces = 0;
+            break;
+        } else if (ntraces == MAX_FILES) {
+            fprintf(stderr, "Máximo %d trazas\n", MAX_FILES);
+            return 1;
+        } else if (load_trace(argv[i]) < 0) {
+            return 1;
+        }
+    }
+    if (ntraces == 0) {
+        fprintf(stderr, "Uso: %s [-g ms] [-v] [-s] traza.qlog...\n"
+                "  -g  marcar huecos sin eventos de más de <ms> (100)\n"
+                "  -v  mostrar también timers, RTT, bytes en vuelo y escrituras\n"
+                "  -s  sólo el resumen\n", argv[0]);
+        return 1;
+    }
+
+    qsort(events, (size_t)nevents, sizeof(*events), cmp_event);
+
+    if (!summary_only && nevents > 0) {
+        double t0 = events[0].abs_ms, prev = t0;
+        printf("%10s  %-*s %s\n", "t_ms", COL_WIDTH, "cliente", "servidor");
+        for (long i = 0; i < nevents; i++) {
+            event_t *e = &events[i];
+            trace_t *t = &traces[e->file];
+            char text[128], tagged[160];
+            if (!describe(e->line, t, verbose, text, sizeof(text))) continue;
+            if (e->abs_ms - prev > gap_ms) {
+                printf("%10s  ~~~ %.3f ms sin eventos ~~~\n", "", e->abs_ms - prev);
+            }
+            prev = e->abs_ms;
+            // con varias trazas del mismo lado se antepone el número de archivo
+            if (ntraces > 2) snprintf(tagged, sizeof(tagged), "[%d] %s", e->file, text);
+            else snprintf(tagged, sizeof(tagged), "%s", text);
+            if (strcmp(t->vantage, "server") == 0) {
+                printf("%10.3f  %-*s %s\n", e->abs_ms - t0, COL_WIDTH, "", tagged);
+            } else {
+                printf("%10.3f  %s\n", e->abs_ms - t0, tagged);
+            }
+        }
+        printf("\n");
+    } else {
+        // el resumen se arma al describir cada evento
+        char text[128];
+        for (long i = 0; i < nevents; i++) {
+            describe(events[i].line, &traces[events[i].file], 0, text, sizeof(text));
+        }
+    }
+
+    for (int i = 0; i < ntraces; i++) print_summary(&traces[i]);
+
+    for (long i = 0; i < nevents; i++) free(events[i].line);
+    free(events);
+    return 0;
+}
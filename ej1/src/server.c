@@ -1,69 +1,163 @@
 // server.c
+#define _GNU_SOURCE   // sched_setaffinity
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <errno.h>
+#include <sched.h>
+#include <signal.h>
+#include <time.h>
 #include <arpa/inet.h>
+#include <sys/ioctl.h>
 #include <sys/select.h>
+#include <linux/sockios.h>
 #include "protocol.h"
+#include "prof.h"
+#include "qlog.h"
+#include "handler.h"
+#include "handoff.h"
+#include "journal.h"
+#include "slow.h"
 
-#define MAX_CLIENTS 10
+// Modo -q: demora entre la recepción en el kernel (SIOCGSTAMPNS) y el
+// recvfrom() de cada paquete, más el CPU usado, desde el último FIN
+typedef struct {
+    long n;
+    long long min_ns, max_ns, sum_ns;
+    struct timespec wall0, cpu0;
+} rx_stats_t;
 
-// Estados del cliente
-typedef enum { STATE_NONE, STATE_AUTH, STATE_WRQ_DONE, STATE_DATA } client_state_t;
+rx_stats_t rx_stats;
 
-typedef struct {
-    struct sockaddr_in addr;
-    int active;
-    client_state_t state;
-    FILE *fp;
-    uint8_t expected_seq;
-} client_t;
+long long ts_diff_ns(struct timespec *a, struct timespec *b) {
+    return (long long)(a->tv_sec - b->tv_sec) * 1000000000LL + (a->tv_nsec - b->tv_nsec);
+}
 
-client_t clients[MAX_CLIENTS];
+void rx_stats_reset() {
+    memset(&rx_stats, 0, sizeof(rx_stats));
+    clock_gettime(CLOCK_REALTIME, &rx_stats.wall0);
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &rx_stats.cpu0);
+}
 
-void init_clients() {
-    for (int i = 0; i < MAX_CLIENTS; i++) clients[i].active = 0;
+void rx_stats_add(int sockfd) {
+    struct timespec stamp, now;
+    // la primera llamada sólo habilita las marcas del socket (ENOENT)
+    if (ioctl(sockfd, SIOCGSTAMPNS, &stamp) < 0) return;
+    clock_gettime(CLOCK_REALTIME, &now);
+    long long d = ts_diff_ns(&now, &stamp);
+    if (rx_stats.n == 0 || d < rx_stats.min_ns) rx_stats.min_ns = d;
+    if (rx_stats.n == 0 || d > rx_stats.max_ns) rx_stats.max_ns = d;
+    rx_stats.sum_ns += d;
+    rx_stats.n++;
 }
 
-// Busca cliente por IP/Puerto o devuelve un slot libre
-int get_client_index(struct sockaddr_in *cli_addr) {
-    int free_idx = -1;
-    for (int i = 0; i < MAX_CLIENTS; i++) {
-        if (clients[i].active) {
-            if (clients[i].addr.sin_addr.s_addr == cli_addr->sin_addr.s_addr &&
-                clients[i].addr.sin_port == cli_addr->sin_port) {
-                return i;
-            }
-        } else {
-            if (free_idx == -1) free_idx = i;
-        }
+void rx_stats_print(int busy) {
+    struct timespec wall, cpu;
+    clock_gettime(CLOCK_REALTIME, &wall);
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu);
+    long long w = ts_diff_ns(&wall, &rx_stats.wall0);
+    if (rx_stats.n > 0) {
+        printf("Recepcion (%s): paquetes=%ld kernel->app min=%.1f us avg=%.1f us max=%.1f us"
+               " cpu=%.1f%%\n", busy ? "busy-poll" : "select", rx_stats.n,
+               rx_stats.min_ns / 1e3, (double)rx_stats.sum_ns / rx_stats.n / 1e3,
+               rx_stats.max_ns / 1e3, w > 0 ? 100.0 * ts_diff_ns(&cpu, &rx_stats.cpu0) / w : 0.0);
     }
-    return free_idx; // Retorna índice libre si es nuevo
+    rx_stats_reset();
 }
 
-void send_ack(int sockfd, struct sockaddr_in *addr, uint8_t seq, char *msg) {
-    struct pdu response;
-    response.type = TYPE_ACK;
-    response.seq_num = seq;
-    memset(response.payload, 0, MAX_PAYLOAD_SIZE);
-    if(msg) strncpy(response.payload, msg, MAX_PAYLOAD_SIZE);
-    
-    // PDU total size: 2 bytes header + payload length
-    sendto(sockfd, &response, 2 + (msg ? strlen(msg) : 0), 0, 
-           (struct sockaddr *)addr, sizeof(*addr));
+// SIGINT/SIGTERM: salir del lazo y cerrar prolijo (archivos, trazas y, en
+// los builds con -fprofile-generate, los perfiles que se escriben en exit)
+volatile sig_atomic_t stop_server;
+
+void on_stop(int sig) {
+    (void)sig;
+    stop_server = 1;
 }
 
-int main() {
+int main(int argc, char *argv[]) {
     int sockfd;
     struct sockaddr_in serv_addr, cli_addr;
     socklen_t len = sizeof(cli_addr);
     char buffer[BUF_SIZE];
+    int busy = 0, busy_poll_us = 0, rx_stamp = 0;
+    const char *handoff_path = NULL, *journal_path = NULL;
+    int handoff_fd = -1, taken = 0, handed_off = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            busy = 1;
+            busy_poll_us = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-q") == 0) {
+            rx_stamp = 1;
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            hio.qlog_dir = argv[++i];
+        } else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+            stall_us = (uint64_t)(atof(argv[++i]) * 1000);
+        } else if (strcmp(argv[i], "-D") == 0 && i + 1 < argc) {
+            hio.disk_dir = argv[++i];
+        } else if (strcmp(argv[i], "-u") == 0 && i + 1 < argc) {
+            handoff_path = argv[++i];
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            journal_path = argv[++i];
+        } else if (strcmp(argv[i], "-J") == 0 && i + 1 < argc) {
+            checkpoint_every = atoi(argv[++i]);
+        } else if (SLOW_PARSE(argc, argv, &i)) {
+            // opciones del consumidor lento (server_tester)
+        } else {
+            fprintf(stderr, "Uso: %s [-b us] [-q] [-t dir] [-d ms] [-D dir] [-u path]"
+                    " [-j diario [-J n]]\n"
+                    "  -b  busy-poll: en vez de select() se gira sobre recvfrom() no\n"
+                    "      bloqueante en un core fijo, con SO_BUSY_POLL=<us> (0 = sólo girar)\n"
+                    "  -q  medir la demora kernel -> aplicación y el CPU (se informa en cada FIN)\n"
+                    "  -t  traza de eventos por sesión en <dir>/server_<n>_<ip>_<puerto>.qlog\n"
+                    "  -d  alertar por stderr las operaciones de disco de más de <ms> (100)\n"
+                    "  -D  además, alertas en <dir>/disk_alerts.csv e histogramas de disco\n"
+                    "      en <dir>/disk_latency.csv en cada FIN\n"
+                    "  -u  reinicio sin cortes: si ya hay un servidor con el mismo <path> le\n"
+                    "      toma el socket y las sesiones abiertas; después espera al siguiente\n"
+                    "  -j  diario de subidas en curso: tras una caída, un cliente con -r sigue\n"
+                    "      desde el último checkpoint, que se hace cada <n> DATA (-J, 64)\n"
+                    SLOW_USAGE, argv[0]);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // Las señales de corte (y la de volcado de -DSERVER_PROFILE) quedan
+    // bloqueadas salvo dentro de pselect(): si llegan entre el chequeo de
+    // stop_server y la espera, la cortan igual en vez de perderse hasta el
+    // próximo paquete. Se bloquean antes de crear cualquier hilo (vigía de
+    // disco, escritor de trazas) para que lo hereden y la señal le llegue
+    // siempre al principal. En busy-poll no hay espera y se dejan como están.
+    sigset_t blocked, waitmask;
+    sigemptyset(&blocked);
+    sigaddset(&blocked, SIGINT);
+    sigaddset(&blocked, SIGTERM);
+    sigaddset(&blocked, SIGUSR1);
+    if (!busy) sigprocmask(SIG_BLOCK, &blocked, &waitmask);
 
     init_clients();
+    rx_stats_reset();
+    PROF_INIT();
+    SLOW_INIT();
+    disk_watch_start(stall_us);
+
+    // sin SA_RESTART: pselect() vuelve con EINTR y el lazo ve stop_server
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_stop;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    if (journal_path && journal_open(journal_path) < 0) exit(EXIT_FAILURE);
+
+    // -u: si hay un servidor corriendo, su socket UDP pasa a ser el nuestro
+    if (handoff_path && (taken = handoff_take(handoff_path, &sockfd)) < 0) {
+        exit(EXIT_FAILURE);
+    }
 
     // Crear socket UDP
-    if ((sockfd = socket(AF_INET, SOCK_DGRAM, 0)) < 0) {
+    if (!taken && (sockfd = socket(AF_INET, SOCK_DGRAM, 0)) < 0) {
         perror("Socket creation failed");
         exit(EXIT_FAILURE);
     }
@@ -73,124 +167,98 @@ int main() {
     serv_addr.sin_addr.s_addr = INADDR_ANY;
     serv_addr.sin_port = htons(SERVER_PORT);
 
-    if (bind(sockfd, (const struct sockaddr *)&serv_addr, sizeof(serv_addr)) < 0) {
+    if (!taken && bind(sockfd, (const struct sockaddr *)&serv_addr, sizeof(serv_addr)) < 0) {
         perror("Bind failed");
         exit(EXIT_FAILURE);
     }
+    hio.sockfd = sockfd;
+
+    if (handoff_path && (handoff_fd = handoff_listen(handoff_path)) < 0) {
+        exit(EXIT_FAILURE);
+    }
 
     printf("Servidor UDP escuchando en puerto %d...\n", SERVER_PORT);
 
-    fd_set readfds;
-    
-    while (1) {
-        FD_ZERO(&readfds);
-        FD_SET(sockfd, &readfds);
-
-        // select() bloqueante esperando datos
-        if (select(sockfd + 1, &readfds, NULL, NULL, NULL) < 0) {
-            perror("Select error");
-            continue;
+    if (busy) {
+        // Fijar el proceso al core actual: el giro no salta de CPU
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(sched_getcpu(), &set);
+        sched_setaffinity(0, sizeof(set), &set);
+        int one = 1;
+        if (busy_poll_us > 0 &&
+            (setsockopt(sockfd, SOL_SOCKET, SO_BUSY_POLL, &busy_poll_us, sizeof(busy_poll_us)) < 0 ||
+             setsockopt(sockfd, SOL_SOCKET, SO_PREFER_BUSY_POLL, &one, sizeof(one)) < 0)) {
+            perror("SO_BUSY_POLL"); // sin CAP_NET_ADMIN igual se gira
         }
+        printf("Modo busy-poll (SO_BUSY_POLL=%d us).\n", busy_poll_us);
+    }
 
-        if (FD_ISSET(sockfd, &readfds)) {
-            int n = recvfrom(sockfd, buffer, BUF_SIZE, 0, (struct sockaddr *)&cli_addr, &len);
-            if (n < 2) continue; // Paquete invalido (muy corto)
+    fd_set readfds;
+    
+    while (!stop_server) {
+        PROF_POLL();
 
-            struct pdu *packet = (struct pdu *)buffer;
-            int idx = get_client_index(&cli_addr);
+        if (!busy) {
+            FD_ZERO(&readfds);
+            FD_SET(sockfd, &readfds);
+            if (handoff_fd >= 0) FD_SET(handoff_fd, &readfds);
 
-            if (idx == -1) {
-                printf("Servidor lleno, ignorando cliente.\n");
+            // pselect() bloqueante esperando datos; con -t se despierta cada
+            // segundo para mandar a disco las trazas de sesiones quietas
+            struct timespec tv = { 1, 0 };
+            int maxfd = sockfd > handoff_fd ? sockfd : handoff_fd;
+            int ready = pselect(maxfd + 1, &readfds, NULL, NULL, hio.qlog_dir ? &tv : NULL,
+                                &waitmask);
+            if (ready < 0) {
+                if (errno != EINTR) perror("Select error");
                 continue;
             }
-
-            client_t *cli = &clients[idx];
-            
-            // Si es un cliente nuevo en este slot
-            if (!cli->active) {
-                cli->active = 1;
-                cli->addr = cli_addr;
-                cli->state = STATE_NONE;
-                cli->expected_seq = 0;
+            if (ready == 0) {
+                flush_sessions();
+                continue;
             }
-
-            // --- MÁQUINA DE ESTADOS ---
-            
-            // FASE 1: HELLO 
-            if (packet->type == TYPE_HELLO && cli->state == STATE_NONE) {
-                printf("Cliente %d: HELLO recibido con credencial: %.*s\n", idx, n-2, packet->payload);
-                char credencial_valida[] = "g21-0e29"; // Credencial de la catedra
-
-                if (strncmp(packet->payload, credencial_valida, strlen(credencial_valida)) == 0) {
-                    // Credencial OK -> Enviar ACK vacío (éxito)
-                    send_ack(sockfd, &cli_addr, 0, NULL);
-                    cli->state = STATE_AUTH;
-                    cli->expected_seq = 1;
-                } else {
-                    // Credencial MALA -> Enviar ACK con mensaje de error
-                    printf("Cliente %d: Credencial invalida rechazadas.\n", idx);
-                    send_ack(sockfd, &cli_addr, 0, "Credencial Invalida");
-                    // Mantenemos el estado en NONE o reiniciamos
-                    cli->active = 0; 
-                }
+            // un servidor nuevo pide el relevo
+            if (handoff_fd >= 0 && FD_ISSET(handoff_fd, &readfds) &&
+                handoff_give(handoff_fd, sockfd)) {
+                handed_off = 1;
+                break;
             }
-            // FASE 2: WRQ 
-            else if (packet->type == TYPE_WRQ && cli->state == STATE_AUTH) {
-                if (packet->seq_num != 1) continue; // Seq incorrecto
-
-                char filename[20];
-                memset(filename, 0, 20);
-                strncpy(filename, packet->payload, n - 2);
-                
-                printf("Cliente %d: WRQ para archivo %s\n", idx, filename);
-                
-                // Validar nombre (4-10 chars)
-                if (strlen(filename) < 4 || strlen(filename) > 10) {
-                   send_ack(sockfd, &cli_addr, 1, "Error Name");
-                   // Resetear cliente o manejar error
-                   continue;
-                }
+        }
 
-                char path[50];
-                strncpy(path, filename, 49);
-                cli->fp = fopen(path, "wb");
-                
-                if (cli->fp) {
-                    send_ack(sockfd, &cli_addr, 1, NULL);
-                    cli->state = STATE_DATA;
-                    cli->expected_seq = 0;
-                } else {
-                    send_ack(sockfd, &cli_addr, 1, "Error FS");
+        // en busy-poll no se duerme: recvfrom() vuelve enseguida si no hay nada
+        if (busy || FD_ISSET(sockfd, &readfds)) {
+            len = sizeof(cli_addr);
+            PROF_BEGIN(PH_RECV);
+            int n = recvfrom(sockfd, buffer, BUF_SIZE, busy ? MSG_DONTWAIT : 0,
+                             (struct sockaddr *)&cli_addr, &len);
+            if (n < 2) { // Paquete invalido (muy corto) o nada todavía
+                PROF_CANCEL(PH_RECV);
+                // en busy-poll el relevo se atiende en los giros sin paquetes
+                if (busy && n < 0 && handoff_fd >= 0 && handoff_give(handoff_fd, sockfd)) {
+                    handed_off = 1;
+                    break;
                 }
+                continue;
             }
-            // FASE 3: DATA
-            else if (packet->type == TYPE_DATA && cli->state == STATE_DATA) {
-                if (packet->seq_num == cli->expected_seq) {
-                    // Escribir en archivo (n - 2 bytes de header)
-                    fwrite(packet->payload, 1, n - 2, cli->fp);
-                    // Enviar ACK
-                    send_ack(sockfd, &cli_addr, cli->expected_seq, NULL);
-                    // Alternar secuencia (0->1, 1->0)
-                    cli->expected_seq = 1 - cli->expected_seq;
-                } else {
-                    // Retransmisión de ACK anterior (paquete duplicado)
-                    send_ack(sockfd, &cli_addr, 1 - cli->expected_seq, NULL);
-                }
-            }
-            // FASE 4: FIN
-            else if (packet->type == TYPE_FIN && cli->state == STATE_DATA) {
-                printf("Cliente %d: FIN recibido. Cerrando.\n", idx);
-                if (cli->fp) fclose(cli->fp);
-                send_ack(sockfd, &cli_addr, packet->seq_num, NULL);
-                
-                // Liberar slot
-                cli->active = 0;
-                cli->fp = NULL;
-            }
-            else {
-                // Paquete fuera de secuencia o estado incorrecto: ignorar silenciosamente
-            }
+            PROF_END(PH_RECV);
+            SLOW_PACKET();
+            if (rx_stamp) rx_stats_add(sockfd);
+
+            if (handle_packet(buffer, n, &cli_addr) && rx_stamp) rx_stats_print(busy);
         }
     }
+
+    // tras el relevo los archivos siguen abiertos en el proceso nuevo; si no,
+    // las subidas a medias quedan en el diario para retomarlas con -r
+    if (!handed_off) checkpoint_sessions();
+    close_sessions(handed_off ? "handoff" : "shutdown");
+    qlog_shutdown();
+    close(sockfd);
+    if (handoff_fd >= 0) {
+        close(handoff_fd);
+        if (!handed_off) unlink(handoff_path);   // el nuevo ya puso el suyo
+    }
+    printf(handed_off ? "Servidor reemplazado.\n" : "Servidor detenido.\n");
     return 0;
 }
\ No newline at end of file
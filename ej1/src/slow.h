@@ -0,0 +1,93 @@
+// slow.h
+// Simulador de consumidor lento para probar timeouts/reintentos del cliente
+// y la contrapresión del servidor. Sólo existe compilando con -DTEST_SLOW
+// (make server_tester); se configura en runtime:
+//
+//   -sw us   demora extra en cada escritura a disco (cuenta como latencia de
+//            disco: dispara las alertas de -d)
+//   -sa us   demora antes de mandar cada ACK
+//   -sc us   CPU quemado por paquete recibido
+//   -sp pct  aplicar las demoras sólo al pct% de los paquetes (100)
+//
+// Las demoras bloquean el lazo entero, igual que un disco o un CPU lentos de
+// verdad. Sin el define las macros no generan código.
+#ifndef SLOW_H
+#define SLOW_H
+
+#ifdef TEST_SLOW
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct {
+    long write_us, ack_us, cpu_us;
+    int pct;
+} slow_opts_t;
+
+// Definido en handler.c: se lee en server.c y se usa en los dos
+extern slow_opts_t slow;
+
+static inline int slow_hit(void) {
+    return slow.pct >= 100 || rand() % 100 < slow.pct;
+}
+
+static inline void slow_sleep(long us) {
+    if (us <= 0 || !slow_hit()) return;
+    struct timespec ts = { us / 1000000, (us % 1000000) * 1000 };
+    nanosleep(&ts, NULL);
+}
+
+// Gira hasta consumir `us` de CPU del hilo (no de reloj: si el scheduler lo
+// saca, la carga igual se completa)
+static inline void slow_burn(long us) {
+    if (us <= 0 || !slow_hit()) return;
+    struct timespec t0, t;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t0);
+    do {
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t);
+    } while ((t.tv_sec - t0.tv_sec) * 1000000L + (t.tv_nsec - t0.tv_nsec) / 1000 < us);
+}
+
+// Consume argv[*i] (y su valor) si es una opción de slow; 1 si lo era
+static inline int slow_parse(int argc, char *argv[], int *i) {
+    long *dst = NULL;
+    if (*i + 1 >= argc) return 0;
+    if (strcmp(argv[*i], "-sw") == 0) dst = &slow.write_us;
+    else if (strcmp(argv[*i], "-sa") == 0) dst = &slow.ack_us;
+    else if (strcmp(argv[*i], "-sc") == 0) dst = &slow.cpu_us;
+    else if (strcmp(argv[*i], "-sp") == 0) {
+        slow.pct = atoi(argv[++*i]);
+        return 1;
+    }
+    if (!dst) return 0;
+    *dst = atol(argv[++*i]);
+    return 1;
+}
+
+static inline void slow_print(void) {
+    printf("Modo consumidor lento: escritura +%ld us, ACK +%ld us, CPU %ld us/paquete"
+           " (en el %d%% de los paquetes)\n", slow.write_us, slow.ack_us, slow.cpu_us, slow.pct);
+}
+
+#define SLOW_USAGE \
+    "  -sw/-sa/-sc us  (server_tester) demora de escritura, de ACK y CPU por paquete\n" \
+    "  -sp pct         (server_tester) aplicarlas sólo al pct%% de los paquetes\n"
+#define SLOW_PARSE(argc, argv, i) slow_parse(argc, argv, i)
+#define SLOW_INIT()               slow_print()
+#define SLOW_WRITE()              slow_sleep(slow.write_us)
+#define SLOW_ACK()                slow_sleep(slow.ack_us)
+#define SLOW_PACKET()             slow_burn(slow.cpu_us)
+
+#else
+
+#define SLOW_USAGE ""
+#define SLOW_PARSE(argc, argv, i) 0
+#define SLOW_INIT()               ((void)0)
+#define SLOW_WRITE()              ((void)0)
+#define SLOW_ACK()                ((void)0)
+#define SLOW_PACKET()             ((void)0)
+
+#endif
+#endif
@@ -0,0 +1,79 @@
+// trace.h
+// Tracepoints USDT (proveedor "ej1") en las máquinas de estado del cliente y
+// del servidor. Cada uno es un nop más una nota ELF en .note.stapsdt, así que
+// se pueden enganchar en caliente sin recompilar ni prender logs:
+//
+//   bpftrace -l 'usdt:./server:ej1:*'
+//   bpftrace -e 'usdt:./server:ej1:data_dup { @[arg0] = count(); }'
+//   perf buildid-cache --add ./client && perf probe sdt_ej1:retransmit
+//
+// Si está <sys/sdt.h> (systemtap-sdt-dev) se usa ese; si no, en x86-64 y
+// aarch64 las notas se emiten acá con el mismo formato. En cualquier otro caso,
+// o compilando con -DNO_USDT, las macros no generan código.
+// Todos los argumentos se pasan como enteros de 64 bits con signo.
+#ifndef TRACE_H
+#define TRACE_H
+
+#if !defined(NO_USDT) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define TRACE_SDT_SYS 1
+#endif
+#endif
+
+#if defined(NO_USDT)
+#define TRACE_NOOP 1
+#elif defined(TRACE_SDT_SYS)
+#define TRACE1(name, a)       DTRACE_PROBE1(ej1, name, (long long)(a))
+#define TRACE2(name, a, b)    DTRACE_PROBE2(ej1, name, (long long)(a), (long long)(b))
+#define TRACE3(name, a, b, c) DTRACE_PROBE3(ej1, name, (long long)(a), (long long)(b), (long long)(c))
+#elif defined(__ELF__) && (defined(__x86_64__) || defined(__aarch64__))
+
+// Nota stapsdt (tipo 3): dirección del probe, base para corregir el
+// desplazamiento al cargar, semáforo (0 = siempre activo), proveedor, nombre y
+// la descripción de los argumentos ("-8@<operando>").
+#define TRACE_SDT(name, args, ...) \
+    __asm__ __volatile__ ( \
+        "990: nop\n" \
+        ".pushsection .note.stapsdt,\"?\",\"note\"\n" \
+        ".balign 4\n" \
+        ".4byte 992f-991f, 994f-993f, 3\n" \
+        "991: .asciz \"stapsdt\"\n" \
+        "992: .balign 4\n" \
+        "993: .8byte 990b\n" \
+        ".8byte _.stapsdt.base\n" \
+        ".8byte 0\n" \
+        ".asciz \"ej1\"\n" \
+        ".asciz \"" #name "\"\n" \
+        ".asciz \"" args "\"\n" \
+        "994: .balign 4\n" \
+        ".popsection\n" \
+        ".ifndef _.stapsdt.base\n" \
+        ".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n" \
+        ".weak _.stapsdt.base\n" \
+        ".hidden _.stapsdt.base\n" \
+        "_.stapsdt.base: .space 1\n" \
+        ".size _.stapsdt.base, 1\n" \
+        ".popsection\n" \
+        ".endif\n" \
+        :: __VA_ARGS__)
+
+#define TRACE_ARG(x) "nor"((long long)(x))
+#define TRACE1(name, a) \
+    TRACE_SDT(name, "-8@%0", TRACE_ARG(a))
+#define TRACE2(name, a, b) \
+    TRACE_SDT(name, "-8@%0 -8@%1", TRACE_ARG(a), TRACE_ARG(b))
+#define TRACE3(name, a, b, c) \
+    TRACE_SDT(name, "-8@%0 -8@%1 -8@%2", TRACE_ARG(a), TRACE_ARG(b), TRACE_ARG(c))
+
+#else
+#define TRACE_NOOP 1
+#endif
+
+#ifdef TRACE_NOOP
+#define TRACE1(name, a)       ((void)0)
+#define TRACE2(name, a, b)    ((void)0)
+#define TRACE3(name, a, b, c) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,209 @@
+// bulk.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/sendfile.h>
+#include <sys/resource.h>
+#include <linux/errqueue.h>
+#include "probe.h"
+#include "bulk.h"
+
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY 60
+#endif
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
+
+// Tiempo de CPU (usuario + sistema) consumido por el proceso, en us
+uint64_t cpu_time_us(void) {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return (uint64_t)(ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000000ULL +
+           (uint64_t)(ru.ru_utime.tv_usec + ru.ru_stime.tv_usec);
+}
+
+static void meter_print(const bulk_meter_t *m, const char *label, uint64_t from_us,
+                        uint64_t to_us, uint64_t bytes, uint64_t cpu_us) {
+    double secs = (double)(to_us - from_us) / 1e6;
+    if (secs <= 0) return;
+    printf("%s %s [%6.1f-%6.1f s] %10.2f Mbit/s  cpu=%5.1f%%\n", m->tag, label,
+           (double)(from_us - m->start_us) / 1e6, (double)(to_us - m->start_us) / 1e6,
+           (double)bytes * 8.0 / secs / 1e6, 100.0 * (double)cpu_us / 1e6 / secs);
+}
+
+void bulk_meter_init(bulk_meter_t *m, const char *tag, int interval_ms) {
+    memset(m, 0, sizeof(*m));
+    m->tag = tag;
+    m->start_us = m->last_us = now_us();
+    m->cpu_start_us = m->cpu_last_us = cpu_time_us();
+    m->interval_us = (uint64_t)(interval_ms > 0 ? interval_ms : 0) * 1000ULL;
+}
+
+void bulk_meter_add(bulk_meter_t *m, uint64_t bytes) {
+    m->bytes_total += bytes;
+    m->bytes_interval += bytes;
+    if (!m->tag || m->interval_us == 0) return;
+
+    uint64_t t = now_us();
+    if (t - m->last_us < m->interval_us) return;
+
+    uint64_t cpu = cpu_time_us();
+    meter_print(m, "intervalo", m->last_us, t, m->bytes_interval, cpu - m->cpu_last_us);
+    m->last_us = t;
+    m->cpu_last_us = cpu;
+    m->bytes_interval = 0;
+}
+
+void bulk_meter_finish(bulk_meter_t *m) {
+    if (!m->tag) return;
+    uint64_t t = now_us();
+    printf("RESUMEN %s: bytes=%llu\n", m->tag, (unsigned long long)m->bytes_total);
+    meter_print(m, "total", m->start_us, t, m->bytes_total, cpu_time_us() - m->cpu_start_us);
+}
+
+// Vacía la cola de errores del socket, donde llegan las notificaciones de
+// MSG_ZEROCOPY. El buffer de ceros nunca se modifica, así que no hace falta
+// esperar a cada notificación: sólo evitar que se acumulen (ENOBUFS).
+static void drain_zerocopy(int sockfd) {
+    char control[128];
+    struct msghdr msg;
+    while (1) {
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        if (recvmsg(sockfd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) break;
+    }
+}
+
+int64_t bulk_send(int sockfd, const bulk_opts_t *opts, const char *tag) {
+    static const char zeros[BULK_CHUNK]; // compartido entre flujos, sólo lectura
+    int filefd = -1;
+    int zerocopy = 0;
+    off_t off = 0;
+
+    if (opts->file) {
+        if ((filefd = open(opts->file, O_RDONLY)) < 0) {
+            perror("open bulk file");
+            return -1;
+        }
+    } else if (opts->zerocopy) {
+        int one = 1;
+        if (setsockopt(sockfd, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) == 0) {
+            zerocopy = 1;
+        } else {
+            perror("SO_ZEROCOPY (se usa send() normal)");
+        }
+    }
+
+    bulk_meter_t m;
+    bulk_meter_init(&m, tag, opts->interval_ms);
+    uint64_t end_us = m.start_us + (uint64_t)opts->duration_s * 1000000ULL;
+    int64_t ret = 0;
+
+    while ((opts->once && filefd >= 0) || now_us() < end_us) {
+        ssize_t n;
+        if (filefd >= 0) {
+            n = sendfile(sockfd, filefd, &off, BULK_CHUNK);
+            if (n == 0) {          // fin de archivo: volver a empezar
+                if (opts->once) break;
+                if (off == 0) {
+                    fprintf(stderr, "Archivo de carga vacío\n");
+                    ret = -1;
+                    break;
+                }
+                off = 0;
+                continue;
+            }
+        } else {
+            n = send(sockfd, zeros, BULK_CHUNK, zerocopy ? MSG_ZEROCOPY : 0);
+            if (zerocopy) {
+                if (n < 0 && errno == ENOBUFS) { // cola de notificaciones llena
+                    drain_zerocopy(sockfd);
+                    continue;
+                }
+                drain_zerocopy(sockfd);
+            }
+        }
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("bulk send");
+            ret = -1;
+            break;
+        }
+        bulk_meter_add(&m, (uint64_t)n);
+    }
+
+    bulk_meter_finish(&m);
+    if (filefd >= 0) close(filefd);
+    return ret < 0 ? -1 : (int64_t)m.bytes_total;
+}
+
+int64_t bulk_sink(int sockfd, int use_splice, int interval_ms, const char *tag) {
+    int pipefd[2] = { -1, -1 };
+    int nullfd = -1;
+    char *buf = NULL;
+
+    if (use_splice) {
+        // socket -> pipe -> /dev/null sin copiar a espacio de usuario
+        if (pipe(pipefd) < 0 || (nullfd = open("/dev/null", O_WRONLY)) < 0) {
+            perror("splice setup");
+            use_splice = 0;
+        } else {
+            fcntl(pipefd[1], F_SETPIPE_SZ, BULK_CHUNK);
+        }
+    }
+    if (!use_splice && !(buf = malloc(BULK_CHUNK))) {
+        perror("malloc");
+        return -1;
+    }
+
+    bulk_meter_t m;
+    bulk_meter_init(&m, tag, interval_ms);
+    int64_t ret = 0;
+
+    while (1) {
+        ssize_t n;
+        if (use_splice) {
+            n = splice(sockfd, NULL, pipefd[1], NULL, BULK_CHUNK,
+                       SPLICE_F_MOVE | SPLICE_F_MORE);
+            if (n > 0) {
+                ssize_t left = n;
+                while (left > 0) {
+                    ssize_t w = splice(pipefd[0], NULL, nullfd, NULL, (size_t)left,
+                                       SPLICE_F_MOVE | SPLICE_F_MORE);
+                    if (w <= 0) {
+                        if (w < 0 && errno == EINTR) continue;
+                        perror("splice /dev/null");
+                        ret = -1;
+                        break;
+                    }
+                    left -= w;
+                }
+                if (ret < 0) break;
+            }
+        } else {
+            n = read(sockfd, buf, BULK_CHUNK);
+        }
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("bulk read");
+            ret = -1;
+            break;
+        }
+        if (n == 0) break; // el emisor cerró la conexión
+        bulk_meter_add(&m, (uint64_t)n);
+    }
+
+    bulk_meter_finish(&m);
+    free(buf);
+    if (pipefd[0] >= 0) close(pipefd[0]);
+    if (pipefd[1] >= 0) close(pipefd[1]);
+    if (nullfd >= 0) close(nullfd);
+    return ret < 0 ? -1 : (int64_t)m.bytes_total;
+}
@@ -0,0 +1,36 @@
+// bulk.h
+// Modo throughput (estilo iperf): emisor y sumidero de flujos TCP masivos
+#ifndef BULK_H
+#define BULK_H
+
+#include <stdint.h>
+
+#define BULK_CHUNK        (1 << 20)  // 1 MiB por llamada de envío/lectura
+#define BULK_INTERVAL_MS  1000       // período de reporte por defecto
+
+typedef struct {
+    const char *file;   // origen: archivo (sendfile) o NULL => buffer de ceros
+    int zerocopy;       // con buffer de ceros: send(MSG_ZEROCOPY)
+    int duration_s;
+    int interval_ms;    // 0 => sin reportes por intervalo
+    int once;           // con archivo: enviarlo una sola vez, sin límite de tiempo
+} bulk_opts_t;
+
+// Medidor de throughput y uso de CPU por intervalo
+typedef struct {
+    const char *tag;        // prefijo de los reportes (NULL => silencioso)
+    uint64_t start_us, last_us, interval_us;
+    uint64_t cpu_start_us, cpu_last_us;
+    uint64_t bytes_total, bytes_interval;
+} bulk_meter_t;
+
+uint64_t cpu_time_us(void);
+void bulk_meter_init(bulk_meter_t *m, const char *tag, int interval_ms);
+void bulk_meter_add(bulk_meter_t *m, uint64_t bytes);
+void bulk_meter_finish(bulk_meter_t *m);
+
+// Ambas devuelven los bytes transferidos o -1 ante error de la conexión
+int64_t bulk_send(int sockfd, const bulk_opts_t *opts, const char *tag);
+int64_t bulk_sink(int sockfd, int use_splice, int interval_ms, const char *tag);
+
+#endif
@@ -0,0 +1,117 @@
+// csv_log.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <glob.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "probe.h"
+#include "csv_log.h"
+
+static int rotating(const csv_log_t *log) {
+    return log->max_bytes > 0 || log->max_age_us > 0;
+}
+
+static int open_segment(csv_log_t *log) {
+    if (rotating(log)) {
+        char stamp[32];
+        time_t t = time(NULL);
+        strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", localtime(&t));
+        snprintf(log->path, sizeof(log->path), "%s-%s-%03u.csv", log->base, stamp,
+                 log->seq++ % 1000);
+    } else {
+        snprintf(log->path, sizeof(log->path), "%s.csv", log->base);
+    }
+
+    log->fp = fopen(log->path, "w");
+    if (!log->fp) {
+        perror("fopen csv");
+        return -1;
+    }
+    log->bytes = 0;
+    log->opened_us = log->last_flush_us = now_us();
+    if (log->header) {
+        fputs(log->header, log->fp);
+        log->bytes += strlen(log->header);
+    }
+    return 0;
+}
+
+// Comprime el segmento cerrado sin bloquear el servidor
+static void archive_segment(const char *path) {
+    pid_t pid = fork();
+    if (pid == 0) {
+        execlp("gzip", "gzip", "-f", path, (char *)NULL);
+        _exit(127);
+    }
+    if (pid < 0) perror("fork gzip");
+}
+
+// Borra los segmentos comprimidos más viejos por encima de `keep`
+static void prune_archives(const csv_log_t *log) {
+    if (log->keep <= 0) return;
+    char pattern[300];
+    glob_t g;
+    snprintf(pattern, sizeof(pattern), "%s-*.csv.gz", log->base);
+    if (glob(pattern, 0, NULL, &g) != 0) return;
+    // glob ordena alfabéticamente == cronológicamente por el nombre
+    for (size_t i = 0; i + (size_t)log->keep < g.gl_pathc; i++) {
+        unlink(g.gl_pathv[i]);
+    }
+    globfree(&g);
+}
+
+static int rotate(csv_log_t *log) {
+    fclose(log->fp);
+    log->fp = NULL;
+    archive_segment(log->path);
+    return open_segment(log);
+}
+
+int csv_log_open(csv_log_t *log) {
+    log->seq = 0;
+    log->fp = NULL;
+    return open_segment(log);
+}
+
+int csv_log_write(csv_log_t *log, const char *line, size_t len) {
+    if (!log->fp) return -1;
+    if (fwrite(line, 1, len, log->fp) != len) return -1;
+    log->bytes += len;
+    if (log->max_bytes > 0 && log->bytes >= log->max_bytes) {
+        return rotate(log);
+    }
+    return 0;
+}
+
+void csv_log_tick(csv_log_t *log) {
+    int reaped = 0;
+    while (waitpid(-1, NULL, WNOHANG) > 0) reaped++;   // gzip terminados
+    if (reaped) prune_archives(log);
+    if (!log->fp) return;
+
+    uint64_t t = now_us();
+    if (log->max_age_us > 0 && t - log->opened_us >= log->max_age_us) {
+        rotate(log);
+        return;
+    }
+    if (t - log->last_flush_us >= (uint64_t)log->flush_ms * 1000ULL) {
+        fflush(log->fp);
+        log->last_flush_us = t;
+    }
+}
+
+void csv_log_close(csv_log_t *log) {
+    if (!log->fp) return;
+    fclose(log->fp);
+    log->fp = NULL;
+    // El último segmento también se archiva; se espera a gzip para no dejar
+    // archivos a medio comprimir al salir
+    if (rotating(log)) {
+        archive_segment(log->path);
+        while (wait(NULL) > 0) {
+        }
+        prune_archives(log);
+    }
+}
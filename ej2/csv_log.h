@@ -0,0 +1,33 @@
+// csv_log.h
+// Salida CSV del servidor de sondas. Sin rotación escribe <base>.csv como
+// siempre; con rotación escribe segmentos <base>-AAAAMMDD-HHMMSS-NNN.csv que
+// al cerrarse se comprimen con gzip en segundo plano, conservando sólo los
+// últimos `keep`. En ambos casos se hace flush periódico para no perder más
+// de flush_ms de datos si el proceso muere.
+#ifndef CSV_LOG_H
+#define CSV_LOG_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+typedef struct {
+    const char *base;         // p.ej. "owd_results"
+    const char *header;       // se repite al inicio de cada segmento
+    uint64_t    max_bytes;    // 0 => sin rotación por tamaño
+    uint64_t    max_age_us;   // 0 => sin rotación por tiempo
+    int         keep;         // segmentos comprimidos a conservar (0 => todos)
+    int         flush_ms;
+
+    FILE       *fp;
+    char        path[256];
+    uint64_t    bytes, opened_us, last_flush_us;
+    unsigned    seq;
+} csv_log_t;
+
+int  csv_log_open(csv_log_t *log);
+int  csv_log_write(csv_log_t *log, const char *line, size_t len);
+// Flush periódico, rotación por tiempo y cosecha de los gzip terminados
+void csv_log_tick(csv_log_t *log);
+void csv_log_close(csv_log_t *log);
+
+#endif
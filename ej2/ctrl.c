@@ -0,0 +1,117 @@
+// ctrl.c
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "probe.h"
+#include "ctrl.h"
+
+#define CTRL_MAX_CLIENTS 64
+
+// Lee una línea terminada en '\n' (sin el '\n'); -1 si se corta antes
+static int read_line(int fd, char *buf, size_t len) {
+    size_t used = 0;
+    while (used + 1 < len) {
+        ssize_t n = recv(fd, buf + used, 1, 0);
+        if (n <= 0) return -1;
+        if (buf[used] == '\n') break;
+        used++;
+    }
+    buf[used] = '\0';
+    return (int)used;
+}
+
+int ctrl_start_clients(int port, int n, int lead_ms, volatile sig_atomic_t *stop) {
+    struct sockaddr_in addr;
+    int fds[CTRL_MAX_CLIENTS];
+    int count = 0;
+
+    if (n <= 0 || n > CTRL_MAX_CLIENTS) {
+        fprintf(stderr, "Cantidad de clientes inválida (1-%d)\n", CTRL_MAX_CLIENTS);
+        return -1;
+    }
+
+    int listenfd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listenfd < 0) {
+        perror("ctrl socket");
+        return -1;
+    }
+    int opt = 1;
+    setsockopt(listenfd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = INADDR_ANY;
+    addr.sin_port        = htons(port);
+
+    if (bind(listenfd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        listen(listenfd, CTRL_MAX_CLIENTS) < 0) {
+        perror("ctrl bind/listen");
+        close(listenfd);
+        return -1;
+    }
+
+    printf("Esperando %d clientes en el puerto de control %d...\n", n, port);
+    while (count < n && !*stop) {
+        char line[32];
+        int fd = accept(listenfd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            perror("ctrl accept");
+            break;
+        }
+        if (read_line(fd, line, sizeof(line)) < 0 || strcmp(line, "REG") != 0) {
+            close(fd);  // no es un cliente de sondas
+            continue;
+        }
+        fds[count++] = fd;
+        printf("Cliente registrado (%d/%d).\n", count, n);
+    }
+    close(listenfd);
+
+    int ret = count == n ? 0 : -1;
+    if (ret == 0) {
+        // todos reciben el mismo instante absoluto; el margen cubre el envío
+        uint64_t epoch_us = now_us() + (uint64_t)lead_ms * 1000ULL;
+        for (int i = 0; i < count; i++) {
+            char msg[64];
+            int len = snprintf(msg, sizeof(msg), "START %llu %d %d\n",
+                               (unsigned long long)epoch_us, i, n);
+            if (send_all(fds[i], msg, (size_t)len) < 0) {
+                perror("ctrl send");
+                ret = -1;
+            }
+        }
+        printf("Inicio sincronizado en %d ms.\n", lead_ms);
+    }
+    for (int i = 0; i < count; i++) close(fds[i]);
+    return ret;
+}
+
+int ctrl_wait_start(const struct sockaddr_in *addr, uint64_t *epoch_us,
+                    int *idx, int *n) {
+    char line[64];
+    unsigned long long epoch;
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        perror("ctrl socket");
+        return -1;
+    }
+    if (connect(fd, (const struct sockaddr *)addr, sizeof(*addr)) < 0) {
+        perror("ctrl connect");
+        close(fd);
+        return -1;
+    }
+    if (send_all(fd, "REG\n", 4) < 0 ||
+        read_line(fd, line, sizeof(line)) < 0 ||
+        sscanf(line, "START %llu %d %d", &epoch, idx, n) != 3) {
+        fprintf(stderr, "Canal de control: respuesta inválida\n");
+        close(fd);
+        return -1;
+    }
+    close(fd);
+    *epoch_us = epoch;
+    return 0;
+}
@@ -0,0 +1,20 @@
+// ctrl.h
+// Canal de control para arrancar varios clientes a la vez: cada cliente se
+// registra con "REG\n" y, cuando están todos, el servidor les manda
+// "START <epoch_us> <i> <n>\n" con el mismo instante absoluto de inicio
+#ifndef CTRL_H
+#define CTRL_H
+
+#include <stdint.h>
+#include <signal.h>
+#include <arpa/inet.h>
+
+// Servidor: espera <n> registros en <port> y difunde un inicio <lead_ms> en
+// el futuro. Vuelve -1 si falla o si *stop se activa mientras espera.
+int ctrl_start_clients(int port, int n, int lead_ms, volatile sig_atomic_t *stop);
+
+// Cliente: se registra en addr (con el puerto ya puesto) y espera el inicio
+int ctrl_wait_start(const struct sockaddr_in *addr, uint64_t *epoch_us,
+                    int *idx, int *n);
+
+#endif
@@ -0,0 +1,76 @@
+// monitor.c
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include "monitor.h"
+
+void monitor_init(monitor_t *m) {
+    m->listenfd = -1;
+    for (int i = 0; i < MONITOR_MAX_CLIENTS; i++) m->clients[i] = -1;
+}
+
+int monitor_open(monitor_t *m, int port) {
+    struct sockaddr_in addr;
+    monitor_init(m);
+
+    if ((m->listenfd = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
+        perror("monitor socket");
+        return -1;
+    }
+    int opt = 1;
+    setsockopt(m->listenfd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);  // sólo local
+    addr.sin_port        = htons(port);
+
+    if (bind(m->listenfd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        listen(m->listenfd, MONITOR_MAX_CLIENTS) < 0) {
+        perror("monitor bind/listen");
+        close(m->listenfd);
+        m->listenfd = -1;
+        return -1;
+    }
+    fcntl(m->listenfd, F_SETFL, fcntl(m->listenfd, F_GETFL) | O_NONBLOCK);
+    return 0;
+}
+
+void monitor_accept(monitor_t *m) {
+    if (m->listenfd < 0) return;
+    int fd;
+    while ((fd = accept(m->listenfd, NULL, NULL)) >= 0) {
+        int slot = -1;
+        for (int i = 0; i < MONITOR_MAX_CLIENTS; i++) {
+            if (m->clients[i] < 0) { slot = i; break; }
+        }
+        if (slot < 0) {
+            close(fd);  // sin lugar
+            continue;
+        }
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        m->clients[slot] = fd;
+    }
+}
+
+void monitor_publish(monitor_t *m, const char *line, int len) {
+    for (int i = 0; i < MONITOR_MAX_CLIENTS; i++) {
+        if (m->clients[i] < 0) continue;
+        if (send(m->clients[i], line, (size_t)len, MSG_NOSIGNAL | MSG_DONTWAIT) != len) {
+            close(m->clients[i]);
+            m->clients[i] = -1;
+        }
+    }
+}
+
+void monitor_close(monitor_t *m) {
+    for (int i = 0; i < MONITOR_MAX_CLIENTS; i++) {
+        if (m->clients[i] >= 0) close(m->clients[i]);
+        m->clients[i] = -1;
+    }
+    if (m->listenfd >= 0) close(m->listenfd);
+    m->listenfd = -1;
+}
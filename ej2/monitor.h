@@ -0,0 +1,23 @@
+// monitor.h
+// Socket de monitoreo en localhost: cada cliente conectado recibe las
+// líneas de agregados por intervalo (p.ej. `nc 127.0.0.1 <puerto>`)
+#ifndef MONITOR_H
+#define MONITOR_H
+
+#define MONITOR_MAX_CLIENTS 8
+
+typedef struct {
+    int listenfd;                       // -1 => deshabilitado
+    int clients[MONITOR_MAX_CLIENTS];   // -1 => slot libre
+} monitor_t;
+
+// Deja el monitor deshabilitado y sin clientes; va antes de cualquier otra
+// llamada, se abra o no el socket
+void monitor_init(monitor_t *m);
+int  monitor_open(monitor_t *m, int port);
+void monitor_accept(monitor_t *m);
+// Nunca bloquea: un cliente lento o caído se desconecta
+void monitor_publish(monitor_t *m, const char *line, int len);
+void monitor_close(monitor_t *m);
+
+#endif
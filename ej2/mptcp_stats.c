@@ -0,0 +1,112 @@
+// mptcp_stats.c
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <linux/tcp.h>
+#include <linux/mptcp.h>
+#include "mptcp_stats.h"
+
+#ifndef IPPROTO_MPTCP
+#define IPPROTO_MPTCP 262
+#endif
+#ifndef SOL_MPTCP
+#define SOL_MPTCP 284
+#endif
+
+int mptcp_socket(int mptcp) {
+    if (mptcp) {
+        int fd = socket(AF_INET, SOCK_STREAM, IPPROTO_MPTCP);
+        if (fd >= 0) return fd;
+        // EPROTONOSUPPORT/EINVAL: kernel sin MPTCP; ENOPROTOOPT: net.mptcp.enabled=0
+        static int warned;
+        if (!warned) {
+            fprintf(stderr, "MPTCP no disponible (%s), se usa TCP\n", strerror(errno));
+            warned = 1;
+        }
+    }
+    return socket(AF_INET, SOCK_STREAM, 0);
+}
+
+static void format_addr(const struct sockaddr_in *a, char *buf, size_t len) {
+    char ip[INET_ADDRSTRLEN] = "?";
+    inet_ntop(AF_INET, &a->sin_addr, ip, sizeof(ip));
+    snprintf(buf, len, "%s:%u", ip, ntohs(a->sin_port));
+}
+
+void mptcp_snapshot(int fd, mptcp_snapshot_t *s) {
+    memset(s, 0, sizeof(*s));
+
+    struct mptcp_info info;
+    socklen_t len = sizeof(info);
+    memset(&info, 0, sizeof(info));
+    if (getsockopt(fd, SOL_MPTCP, MPTCP_INFO, &info, &len) < 0 ||
+        (info.mptcpi_flags & MPTCP_INFO_FLAG_FALLBACK)) {
+        s->fallback = 1;
+        return;
+    }
+
+    // Ambas opciones devuelven un encabezado mptcp_subflow_data seguido de
+    // un elemento de size_user bytes por subflujo
+    struct {
+        struct mptcp_subflow_data hdr;
+        struct tcp_info           ti[MPTCP_MAX_SUBFLOWS];
+    } tcp;
+    struct {
+        struct mptcp_subflow_data  hdr;
+        struct mptcp_subflow_addrs a[MPTCP_MAX_SUBFLOWS];
+    } addrs;
+
+    memset(&tcp, 0, sizeof(tcp));
+    tcp.hdr.size_subflow_data = sizeof(tcp.hdr);
+    tcp.hdr.size_user = sizeof(struct tcp_info);
+    len = sizeof(tcp);
+    if (getsockopt(fd, SOL_MPTCP, MPTCP_TCPINFO, &tcp, &len) < 0) {
+        s->n = info.mptcpi_subflows;   // kernel viejo: sólo la cantidad
+        return;
+    }
+    s->n = (int)tcp.hdr.num_subflows;
+    if (s->n > MPTCP_MAX_SUBFLOWS) s->n = MPTCP_MAX_SUBFLOWS;
+
+    memset(&addrs, 0, sizeof(addrs));
+    addrs.hdr.size_subflow_data = sizeof(addrs.hdr);
+    addrs.hdr.size_user = sizeof(struct mptcp_subflow_addrs);
+    len = sizeof(addrs);
+    int have_addrs = getsockopt(fd, SOL_MPTCP, MPTCP_SUBFLOW_ADDRS, &addrs, &len) == 0;
+
+    for (int i = 0; i < s->n; i++) {
+        mptcp_subflow_t *sf = &s->sf[i];
+        const struct tcp_info *ti = &tcp.ti[i];
+        sf->rtt_us = ti->tcpi_rtt;
+        sf->rttvar_us = ti->tcpi_rttvar;
+        sf->cwnd = ti->tcpi_snd_cwnd;
+        sf->retrans = ti->tcpi_total_retrans;
+        sf->bytes_sent = ti->tcpi_bytes_sent;
+        sf->bytes_received = ti->tcpi_bytes_received;
+        if (have_addrs && i < (int)addrs.hdr.num_subflows &&
+            addrs.a[i].sa_family == AF_INET) {
+            format_addr(&addrs.a[i].sin_local, sf->local, sizeof(sf->local));
+            format_addr(&addrs.a[i].sin_remote, sf->remote, sizeof(sf->remote));
+        } else {
+            snprintf(sf->local, sizeof(sf->local), "?");
+            snprintf(sf->remote, sizeof(sf->remote), "?");
+        }
+    }
+}
+
+void mptcp_print(const mptcp_snapshot_t *s, const char *tag) {
+    if (s->fallback) {
+        printf("RESUMEN %s: mptcp=no (TCP común)\n", tag);
+        return;
+    }
+    printf("RESUMEN %s: mptcp=si subflujos=%d\n", tag, s->n);
+    for (int i = 0; i < s->n; i++) {
+        const mptcp_subflow_t *sf = &s->sf[i];
+        printf("  subflujo %d %s -> %s rtt_ms=%.3f rttvar_ms=%.3f cwnd=%u retrans=%u "
+               "bytes_tx=%llu bytes_rx=%llu\n", i, sf->local, sf->remote,
+               sf->rtt_us / 1e3, sf->rttvar_us / 1e3, sf->cwnd, sf->retrans,
+               (unsigned long long)sf->bytes_sent, (unsigned long long)sf->bytes_received);
+    }
+}
@@ -0,0 +1,30 @@
+// mptcp_stats.h
+// Sockets MPTCP (con vuelta a TCP común si el kernel no lo soporta) y
+// estadísticas por subflujo vía MPTCP_INFO / MPTCP_TCPINFO / MPTCP_SUBFLOW_ADDRS
+#ifndef MPTCP_STATS_H
+#define MPTCP_STATS_H
+
+#include <stdint.h>
+
+#define MPTCP_MAX_SUBFLOWS 8
+
+typedef struct {
+    char     local[48], remote[48];   // "ip:puerto"
+    uint32_t rtt_us, rttvar_us;
+    uint32_t cwnd, retrans;           // retrans = total de retransmisiones
+    uint64_t bytes_sent, bytes_received;
+} mptcp_subflow_t;
+
+typedef struct {
+    int             fallback;         // la conexión terminó siendo TCP común
+    int             n;                // subflujos activos
+    mptcp_subflow_t sf[MPTCP_MAX_SUBFLOWS];
+} mptcp_snapshot_t;
+
+// Socket de flujo: MPTCP si mptcp != 0 y el kernel lo permite, si no TCP
+int  mptcp_socket(int mptcp);
+// Foto de la conexión (n = 0 y fallback = 1 si no es MPTCP)
+void mptcp_snapshot(int fd, mptcp_snapshot_t *s);
+void mptcp_print(const mptcp_snapshot_t *s, const char *tag);
+
+#endif
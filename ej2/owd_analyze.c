@@ -0,0 +1,472 @@
+// owd_analyze.c
+// Análisis offline de owd_results.csv (o udp_owd_results.csv) de cientos de
+// millones de filas: mmap del archivo, parseo en paralelo por bloques de
+// líneas y combinación de histogramas por hilo.
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "owd_stats.h"
+
+#define MAX_THREADS      64
+#define DEFAULT_BUCKET   1000     // filas por punto de la serie
+
+// Estadística de un bucket de la serie (filas consecutivas)
+typedef struct {
+    uint64_t n;
+    uint64_t over;             // muestras por encima del umbral de atípicos
+    int64_t  min_us, max_us;
+    double   sum_us;
+} series_bucket_t;
+
+typedef struct {
+    const char *begin, *end;   // bloque de líneas completas
+    int         column;
+    uint64_t    first_row;     // índice global de la primera fila del bloque
+    uint64_t    rows;          // filas en el bloque (primera pasada)
+    uint64_t    bad;           // filas que no se pudieron parsear
+    uint64_t    bucket_rows;
+    int64_t     thr_us;        // pasada 3: umbral de atípicos
+    int64_t     co_period_us;  // > 0 => corrección de coordinated omission
+    int         co_sched_col, co_missed_col;
+    owd_hist_t  hist;
+    owd_hist_t  hist_co;
+    series_bucket_t *series;   // buckets [first_row / bucket_rows, ...]
+    uint64_t    series_first, series_len;
+} chunk_t;
+
+// Parsea un decimal "[-]ent.frac" en microsegundos (6 decimales como escribe
+// el servidor). Sin locale ni strtod: es el cuello de botella del análisis.
+// `limit` es el fin del bloque mapeado: se puede leer hasta ahí aunque el
+// campo termine antes.
+static int parse_us(const char *p, const char *end, const char *limit, int64_t *out) {
+    int neg = 0;
+    if (p < end && *p == '-') { neg = 1; p++; }
+    if (p >= end || ((unsigned)(*p - '0') > 9 && *p != '.')) return -1;
+
+    int64_t ent = 0;
+    while (p < end && (unsigned)(*p - '0') <= 9) ent = ent * 10 + (*p++ - '0');
+
+    int64_t frac = 0;
+    int digits = 0;
+    if (p < end && *p == '.') {
+        p++;
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        // Los 6 decimales de una vez (SWAR): se cargan 8 bytes (los 2 de más
+        // son la coma o el fin de línea siguientes), se descartan los 2
+        // últimos y se anteponen dos '0' para convertir 8 dígitos
+        if (end - p >= 6 && limit - p >= 8) {
+            uint64_t w;
+            memcpy(&w, p, 8);
+            w = (w << 16) | 0x3030ULL;
+            if ((((w & 0xF0F0F0F0F0F0F0F0ULL) |
+                  (((w + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) ==
+                 0x3333333333333333ULL)) {
+                w = ((w & 0x0F0F0F0F0F0F0F0FULL) * 2561) >> 8;
+                w = ((w & 0x00FF00FF00FF00FFULL) * 6553601) >> 16;
+                w = ((w & 0x0000FFFF0000FFFFULL) * 42949672960001ULL) >> 32;
+                frac = (int64_t)w;
+                digits = 6;
+                p += 6;
+            }
+        }
+#endif
+        while (p < end && (unsigned)(*p - '0') <= 9) {
+            if (digits < 18) { frac = frac * 10 + (*p - '0'); digits++; }
+            p++;
+        }
+    }
+    while (digits > 6) { frac /= 10; digits--; }
+    while (digits < 6) { frac *= 10; digits++; }
+
+    int64_t v = ent * 1000000 + frac;
+    *out = neg ? -v : v;
+    return 0;
+}
+
+static void *count_rows(void *arg) {
+    chunk_t *c = arg;
+    const char *p = c->begin;
+    uint64_t n = 0;
+    while (p < c->end && (p = memchr(p, '\n', (size_t)(c->end - p)))) {
+        n++;
+        p++;
+    }
+    // última línea sin '\n' al final del archivo
+    if (c->end > c->begin && c->end[-1] != '\n') n++;
+    c->rows = n;
+    return NULL;
+}
+
+// Ubica el campo `col` de la línea [p, eol); devuelve su inicio y su fin en *fend
+static const char *field_at(const char *p, const char *eol, int col, const char **fend) {
+    const char *f = p;
+    for (int k = 0; k < col && f < eol; k++) {
+        const char *comma = memchr(f, ',', (size_t)(eol - f));
+        f = comma ? comma + 1 : eol;
+    }
+    const char *e = memchr(f, ',', (size_t)(eol - f));
+    if (!e) e = eol;
+    if (e > f && e[-1] == '\r') e--;
+    *fend = e;
+    return f;
+}
+
+// Recorre las filas del bloque. Pasada 2 (count_over = 0): histograma y
+// serie; pasada 3: sólo cuenta por bucket las muestras sobre el umbral.
+static void scan_chunk(chunk_t *c, int count_over) {
+    const char *p = c->begin;
+    uint64_t row = c->first_row;
+    while (p < c->end) {
+        const char *eol = memchr(p, '\n', (size_t)(c->end - p));
+        if (!eol) eol = c->end;
+
+        const char *fend;
+        const char *f = field_at(p, eol, c->column, &fend);
+
+        int64_t v;
+        if (f < fend && parse_us(f, fend, c->end, &v) == 0) {
+            series_bucket_t *b = &c->series[row / c->bucket_rows - c->series_first];
+            if (count_over) {
+                if (v > c->thr_us) b->over++;
+                row++;
+                p = eol + 1;
+                continue;
+            }
+            hist_add(&c->hist, v);
+            if (c->co_period_us > 0) {
+                const char *se, *me;
+                const char *sf = field_at(p, eol, c->co_sched_col, &se);
+                const char *mf = field_at(p, eol, c->co_missed_col, &me);
+                int64_t sched, missed;
+                if (parse_us(sf, se, c->end, &sched) == 0 &&
+                    parse_us(mf, me, c->end, &missed) == 0 && missed >= 0) {
+                    // "missed" es entero: parse_us lo devuelve escalado por 1e6
+                    hist_add(&c->hist_co, sched);
+                    hist_add_omitted(&c->hist_co, sched, c->co_period_us,
+                                     (uint64_t)(missed / 1000000));
+                }
+            }
+            if (b->n == 0 || v < b->min_us) b->min_us = v;
+            if (b->n == 0 || v > b->max_us) b->max_us = v;
+            b->sum_us += (double)v;
+            b->n++;
+        } else if (!count_over) {
+            c->bad++;
+        }
+        row++;
+        p = eol + 1;
+    }
+}
+
+static void *parse_chunk(void *arg) {
+    chunk_t *c = arg;
+    hist_init(&c->hist);
+    hist_init(&c->hist_co);
+
+    c->series_first = c->first_row / c->bucket_rows;
+    c->series_len = c->rows ? (c->first_row + c->rows - 1) / c->bucket_rows -
+                              c->series_first + 1 : 0;
+    c->series = calloc(c->series_len ? c->series_len : 1, sizeof(series_bucket_t));
+    if (c->series) scan_chunk(c, 0);
+    return NULL;
+}
+
+static void *count_over(void *arg) {
+    scan_chunk(arg, 1);
+    return NULL;
+}
+
+// Devuelve el índice de la columna `name` en la línea de encabezado
+static int find_column(const char *hdr, const char *hdr_end, const char *name) {
+    size_t len = strlen(name);
+    int idx = 0;
+    const char *f = hdr;
+    while (f <= hdr_end) {
+        const char *comma = memchr(f, ',', (size_t)(hdr_end - f));
+        const char *fend = comma ? comma : hdr_end;
+        if (fend > f && fend[-1] == '\r') fend--;
+        if ((size_t)(fend - f) == len && memcmp(f, name, len) == 0) return idx;
+        if (!comma) break;
+        f = comma + 1;
+        idx++;
+    }
+    return -1;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Uso: %s <archivo.csv> [-c columna] [-j hilos] [-b filas] [-t umbral_ms] [-f fraccion]\n"
+            "        [--cdf archivo] [--series archivo] [--co periodo_ms]\n"
+            "  -c  columna a analizar (por defecto delay_s)\n"
+            "  -b  filas por punto de la serie temporal (por defecto %d)\n"
+            "  -t  umbral para ventanas atípicas (por defecto p99.9 global)\n"
+            "  -f  fracción de muestras sobre el umbral que marca un bucket como\n"
+            "      atípico (por defecto 0.01, 10 veces lo esperado para p99.9)\n"
+            "  --cdf     escribe puntos (delay_ms, fraccion) de la CDF\n"
+            "  --series  escribe la serie (fila_inicial, n, min, avg, max)\n"
+            "  --co      percentiles corregidos por coordinated omission a partir de\n"
+            "            sched_delay_s y missed, con el período de envío del cliente\n",
+            prog, DEFAULT_BUCKET);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const char *path = argv[1];
+    const char *col_name = "delay_s";
+    const char *cdf_path = NULL, *series_path = NULL;
+    long nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+    uint64_t bucket_rows = DEFAULT_BUCKET;
+    double threshold_ms = -1;
+    double over_frac = 0.01;
+    double co_period_ms = 0;
+
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            col_name = argv[++i];
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            nthreads = atol(argv[++i]);
+        } else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            bucket_rows = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            threshold_ms = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+            over_frac = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--cdf") == 0 && i + 1 < argc) {
+            cdf_path = argv[++i];
+        } else if (strcmp(argv[i], "--series") == 0 && i + 1 < argc) {
+            series_path = argv[++i];
+        } else if (strcmp(argv[i], "--co") == 0 && i + 1 < argc) {
+            co_period_ms = atof(argv[++i]);
+        } else {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (nthreads < 1) nthreads = 1;
+    if (nthreads > MAX_THREADS) nthreads = MAX_THREADS;
+    if (bucket_rows == 0) bucket_rows = DEFAULT_BUCKET;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror("open");
+        return EXIT_FAILURE;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size == 0) {
+        fprintf(stderr, "Archivo vacío o ilegible\n");
+        close(fd);
+        return EXIT_FAILURE;
+    }
+    size_t size = (size_t)st.st_size;
+    const char *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+        perror("mmap");
+        close(fd);
+        return EXIT_FAILURE;
+    }
+    madvise((void *)data, size, MADV_SEQUENTIAL | MADV_WILLNEED);
+    const char *end = data + size;
+
+    // Encabezado
+    const char *hdr_end = memchr(data, '\n', size);
+    if (!hdr_end) hdr_end = end;
+    int column = find_column(data, hdr_end, col_name);
+    if (column < 0) {
+        fprintf(stderr, "No existe la columna '%s' en el encabezado\n", col_name);
+        munmap((void *)data, size);
+        close(fd);
+        return EXIT_FAILURE;
+    }
+    int sched_col = -1, missed_col = -1;
+    if (co_period_ms > 0) {
+        sched_col = find_column(data, hdr_end, "sched_delay_s");
+        missed_col = find_column(data, hdr_end, "missed");
+        if (sched_col < 0 || missed_col < 0) {
+            fprintf(stderr, "--co requiere las columnas sched_delay_s y missed\n");
+            munmap((void *)data, size);
+            close(fd);
+            return EXIT_FAILURE;
+        }
+    }
+    const char *body = hdr_end < end ? hdr_end + 1 : end;
+
+    // Bloques de igual tamaño alineados a fin de línea
+    static chunk_t chunks[MAX_THREADS];
+    pthread_t th[MAX_THREADS];
+    size_t body_len = (size_t)(end - body);
+    const char *p = body;
+    for (long t = 0; t < nthreads; t++) {
+        chunks[t].begin = p;
+        const char *q = (t == nthreads - 1) ? end : body + body_len * (size_t)(t + 1) / (size_t)nthreads;
+        if (q < p) q = p;
+        if (q < end) {
+            const char *nl = memchr(q, '\n', (size_t)(end - q));
+            q = nl ? nl + 1 : end;
+        }
+        chunks[t].end = q;
+        chunks[t].column = column;
+        chunks[t].bucket_rows = bucket_rows;
+        chunks[t].co_period_us = (int64_t)(co_period_ms * 1e3);
+        chunks[t].co_sched_col = sched_col;
+        chunks[t].co_missed_col = missed_col;
+        p = q;
+    }
+
+    // Pasada 1: contar filas por bloque para conocer el índice global
+    for (long t = 0; t < nthreads; t++) pthread_create(&th[t], NULL, count_rows, &chunks[t]);
+    for (long t = 0; t < nthreads; t++) pthread_join(th[t], NULL);
+    uint64_t rows = 0;
+    for (long t = 0; t < nthreads; t++) {
+        chunks[t].first_row = rows;
+        rows += chunks[t].rows;
+    }
+
+    // Pasada 2: parseo
+    for (long t = 0; t < nthreads; t++) pthread_create(&th[t], NULL, parse_chunk, &chunks[t]);
+    for (long t = 0; t < nthreads; t++) pthread_join(th[t], NULL);
+
+    static owd_hist_t h, h_co;
+    hist_init(&h);
+    hist_init(&h_co);
+    uint64_t bad = 0;
+    uint64_t nbuckets = rows ? (rows - 1) / bucket_rows + 1 : 0;
+    series_bucket_t *series = calloc(nbuckets ? nbuckets : 1, sizeof(series_bucket_t));
+    if (!series) {
+        perror("calloc");
+        return EXIT_FAILURE;
+    }
+    for (long t = 0; t < nthreads; t++) {
+        chunk_t *c = &chunks[t];
+        hist_merge(&h, &c->hist);
+        hist_merge(&h_co, &c->hist_co);
+        bad += c->bad;
+        if (!c->series) {
+            fprintf(stderr, "Sin memoria para la serie\n");
+            return EXIT_FAILURE;
+        }
+        for (uint64_t i = 0; i < c->series_len; i++) {
+            series_bucket_t *src = &c->series[i], *dst = &series[c->series_first + i];
+            if (src->n == 0) continue;
+            if (dst->n == 0 || src->min_us < dst->min_us) dst->min_us = src->min_us;
+            if (dst->n == 0 || src->max_us > dst->max_us) dst->max_us = src->max_us;
+            dst->sum_us += src->sum_us;
+            dst->n += src->n;
+        }
+    }
+
+    printf("Archivo: %s  columna: %s  filas: %llu  invalidas: %llu  hilos: %ld\n",
+           path, col_name, (unsigned long long)rows, (unsigned long long)bad, nthreads);
+    if (h.count == 0) {
+        for (long t = 0; t < nthreads; t++) free(chunks[t].series);
+        free(series);
+        munmap((void *)data, size);
+        close(fd);
+        return EXIT_SUCCESS;
+    }
+
+    static const double pcts[] = { 1, 5, 10, 25, 50, 75, 90, 95, 99, 99.9, 99.99 };
+    printf("min_ms=%.3f avg_ms=%.3f max_ms=%.3f\n", h.min_us / 1e3, hist_mean(&h) / 1e3,
+           h.max_us / 1e3);
+    for (size_t i = 0; i < sizeof(pcts) / sizeof(pcts[0]); i++) {
+        printf("p%-6g %12.3f ms\n", pcts[i], hist_percentile(&h, pcts[i]) / 1e3);
+    }
+
+    if (co_period_ms > 0 && h_co.count > 0) {
+        printf("Corregido por coordinated omission (periodo %.3f ms): muestras=%llu "
+               "(+%llu sintéticas)\n", co_period_ms, (unsigned long long)h_co.count,
+               (unsigned long long)(h_co.count - h.count));
+        for (size_t i = 0; i < sizeof(pcts) / sizeof(pcts[0]); i++) {
+            printf("p%-6g %12.3f ms\n", pcts[i], hist_percentile(&h_co, pcts[i]) / 1e3);
+        }
+    }
+
+    if (cdf_path) {
+        FILE *f = fopen(cdf_path, "w");
+        if (f) {
+            fprintf(f, "delay_ms,fraccion\n");
+            for (int i = 0; i <= 1000; i++) {
+                double pc = i / 10.0;
+                fprintf(f, "%.3f,%.4f\n", hist_percentile(&h, pc) / 1e3, pc / 100.0);
+            }
+            fclose(f);
+        } else {
+            perror("fopen cdf");
+        }
+    }
+
+    if (series_path) {
+        FILE *f = fopen(series_path, "w");
+        if (f) {
+            fprintf(f, "fila,n,min_ms,avg_ms,max_ms\n");
+            for (uint64_t i = 0; i < nbuckets; i++) {
+                series_bucket_t *b = &series[i];
+                if (b->n == 0) continue;
+                fprintf(f, "%llu,%llu,%.3f,%.3f,%.3f\n",
+                        (unsigned long long)(i * bucket_rows), (unsigned long long)b->n,
+                        b->min_us / 1e3, b->sum_us / (double)b->n / 1e3, b->max_us / 1e3);
+            }
+            fclose(f);
+        } else {
+            perror("fopen series");
+        }
+    }
+
+    // Ventanas atípicas: buckets consecutivos con demasiadas muestras sobre el
+    // umbral (pasada 3, el umbral por defecto depende del histograma global)
+    int64_t thr_us = threshold_ms >= 0 ? (int64_t)(threshold_ms * 1e3)
+                                       : hist_percentile(&h, 99.9);
+    for (long t = 0; t < nthreads; t++) {
+        chunks[t].thr_us = thr_us;
+        pthread_create(&th[t], NULL, count_over, &chunks[t]);
+    }
+    for (long t = 0; t < nthreads; t++) pthread_join(th[t], NULL);
+    for (long t = 0; t < nthreads; t++) {
+        chunk_t *c = &chunks[t];
+        for (uint64_t i = 0; i < c->series_len; i++) {
+            series[c->series_first + i].over += c->series[i].over;
+        }
+        free(c->series);
+    }
+
+    printf("Ventanas atípicas (>= %.2f%% de muestras sobre %.3f ms, %llu filas por bucket):\n",
+           over_frac * 100.0, thr_us / 1e3, (unsigned long long)bucket_rows);
+    int windows = 0;
+    for (uint64_t i = 0; i < nbuckets; i++) {
+#define IS_OUTLIER(b) ((b).n && (b).over > 0 && (double)(b).over >= over_frac * (double)(b).n)
+        if (!IS_OUTLIER(series[i])) continue;
+        uint64_t j = i;
+        int64_t worst = series[i].max_us;
+        uint64_t over = series[i].over;
+        while (j + 1 < nbuckets && IS_OUTLIER(series[j + 1])) {
+            j++;
+            over += series[j].over;
+            if (series[j].max_us > worst) worst = series[j].max_us;
+        }
+#undef IS_OUTLIER
+        if (windows < 20) {
+            printf("  filas %llu-%llu  sobre_umbral=%llu  peor=%.3f ms\n",
+                   (unsigned long long)(i * bucket_rows),
+                   (unsigned long long)((j + 1) * bucket_rows - 1),
+                   (unsigned long long)over, worst / 1e3);
+        }
+        windows++;
+        i = j;
+    }
+    if (windows > 20) printf("  ... %d ventanas en total\n", windows);
+    if (windows == 0) printf("  ninguna\n");
+
+    free(series);
+    munmap((void *)data, size);
+    close(fd);
+    return EXIT_SUCCESS;
+}
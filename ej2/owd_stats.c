@@ -0,0 +1,164 @@
+// owd_stats.c
+#include <stdio.h>
+#include <string.h>
+#include "owd_stats.h"
+
+static int bucket_index(int64_t v) {
+    if (v < 0) return 0;
+    uint64_t u = (uint64_t)v;
+    if (u < 2 * HIST_SUB) return (int)u;
+    int msb = 63 - __builtin_clzll(u);
+    if (msb >= HIST_MAX_BITS) return HIST_BUCKETS - 1;
+    int shift = msb - HIST_SUB_BITS;
+    int top = (int)(u >> shift);            // en [HIST_SUB, 2*HIST_SUB)
+    return 2 * HIST_SUB + (shift - 1) * HIST_SUB + (top - HIST_SUB);
+}
+
+// Punto medio del rango de valores que cae en el bucket
+static int64_t bucket_value(int idx) {
+    if (idx < 2 * HIST_SUB) return idx;
+    int rel = idx - 2 * HIST_SUB;
+    int shift = rel / HIST_SUB + 1;
+    int64_t top = HIST_SUB + rel % HIST_SUB;
+    return (top << shift) + ((1LL << shift) >> 1);
+}
+
+// Mayor valor que cae en el bucket
+static int64_t bucket_upper(int idx) {
+    if (idx < 2 * HIST_SUB) return idx;
+    if (idx == HIST_BUCKETS - 1) return INT64_MAX;   // recibe todo lo >= 2^40 us
+    int rel = idx - 2 * HIST_SUB;
+    int shift = rel / HIST_SUB + 1;
+    int64_t top = HIST_SUB + rel % HIST_SUB;
+    return ((top + 1) << shift) - 1;
+}
+
+void hist_init(owd_hist_t *h) {
+    memset(h, 0, sizeof(*h));
+}
+
+void hist_add(owd_hist_t *h, int64_t delay_us) {
+    if (h->count == 0 || delay_us < h->min_us) h->min_us = delay_us;
+    if (h->count == 0 || delay_us > h->max_us) h->max_us = delay_us;
+    h->count++;
+    h->sum_us += (double)delay_us;
+    h->buckets[bucket_index(delay_us)]++;
+}
+
+void hist_merge(owd_hist_t *dst, const owd_hist_t *src) {
+    if (src->count == 0) return;
+    if (dst->count == 0 || src->min_us < dst->min_us) dst->min_us = src->min_us;
+    if (dst->count == 0 || src->max_us > dst->max_us) dst->max_us = src->max_us;
+    dst->count += src->count;
+    dst->sum_us += src->sum_us;
+    for (int i = 0; i < HIST_BUCKETS; i++) dst->buckets[i] += src->buckets[i];
+}
+
+uint64_t hist_add_omitted(owd_hist_t *h, int64_t value_us, int64_t period_us,
+                          uint64_t missed) {
+    if (period_us <= 0 || missed == 0) return 0;
+    if (missed > (uint64_t)(HIST_OMITTED_MAX_US / period_us)) {
+        missed = (uint64_t)(HIST_OMITTED_MAX_US / period_us);
+    }
+    // más allá de 2^40 us todo va al último bucket; así value + k*period no desborda
+    const int64_t lim = 1LL << HIST_MAX_BITS;
+    if (value_us > lim) value_us = lim;
+    if (value_us < -lim) value_us = -lim;
+
+    int64_t first = value_us + period_us, last = value_us + (int64_t)missed * period_us;
+    if (h->count == 0 || first < h->min_us) h->min_us = first;
+    if (h->count == 0 || last > h->max_us) h->max_us = last;
+    h->count += missed;
+
+    // Las muestras son una progresión aritmética: se cuenta de una vez cuántas
+    // caen en cada bucket, así que el costo es O(buckets) y no O(missed)
+    for (uint64_t k = 1; k <= missed;) {
+        int64_t v = value_us + (int64_t)k * period_us;
+        int b = bucket_index(v);
+        int64_t hi = bucket_upper(b);
+        uint64_t n = missed - k + 1;
+        if (hi != INT64_MAX && (uint64_t)((hi - v) / period_us) + 1 < n) {
+            n = (uint64_t)((hi - v) / period_us) + 1;
+        }
+        h->buckets[b] += n;
+        h->sum_us += (double)n * (double)v + (double)period_us * (double)n * (double)(n - 1) / 2;
+        k += n;
+    }
+    return missed;
+}
+
+int64_t hist_percentile(const owd_hist_t *h, double p) {
+    if (h->count == 0) return 0;
+    if (p <= 0) return h->min_us;
+    if (p >= 100) return h->max_us;
+
+    uint64_t rank = (uint64_t)(p / 100.0 * (double)h->count + 0.5);
+    if (rank == 0) rank = 1;
+    uint64_t acc = 0;
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+        acc += h->buckets[i];
+        if (acc >= rank) {
+            int64_t v = bucket_value(i);
+            if (v < h->min_us) v = h->min_us;
+            if (v > h->max_us) v = h->max_us;
+            return v;
+        }
+    }
+    return h->max_us;
+}
+
+double hist_mean(const owd_hist_t *h) {
+    return h->count ? h->sum_us / (double)h->count : 0.0;
+}
+
+void pdv_init(owd_pdv_t *v) {
+    memset(v, 0, sizeof(*v));
+    hist_init(&v->ipdv_abs);
+}
+
+void pdv_add(owd_pdv_t *v, int64_t delay_us, int64_t *ipdv_us, int64_t *pdv_us) {
+    int64_t ipdv = 0;
+    if (v->have_prev) {
+        ipdv = delay_us - v->prev_delay_us;
+        int64_t a = ipdv < 0 ? -ipdv : ipdv;
+        v->jitter_us += ((double)a - v->jitter_us) / 16.0;
+        hist_add(&v->ipdv_abs, a);
+        if (delay_us < v->min_delay_us) v->min_delay_us = delay_us;
+    } else {
+        v->min_delay_us = delay_us;
+        v->have_prev = 1;
+    }
+    v->prev_delay_us = delay_us;
+
+    if (ipdv_us) *ipdv_us = ipdv;
+    if (pdv_us) *pdv_us = delay_us - v->min_delay_us;
+}
+
+void interval_init(owd_interval_t *iv, uint64_t start_us, int interval_ms) {
+    memset(iv, 0, sizeof(*iv));
+    iv->start_us = start_us;
+    iv->interval_us = (uint64_t)interval_ms * 1000ULL;
+}
+
+void interval_add(owd_interval_t *iv, int64_t delay_us, size_t bytes) {
+    hist_add(&iv->hist, delay_us);
+    iv->bytes += bytes;
+}
+
+int interval_flush(owd_interval_t *iv, uint64_t t0_us, uint64_t end_us,
+                   double jitter_us, char *line, size_t len) {
+    const owd_hist_t *h = &iv->hist;
+    int n = snprintf(line, len,
+                     "t=%.3f n=%llu bytes=%llu min_ms=%.3f avg_ms=%.3f p50_ms=%.3f "
+                     "p99_ms=%.3f max_ms=%.3f jitter_ms=%.3f\n",
+                     (double)(end_us - t0_us) / 1e6,
+                     (unsigned long long)h->count, (unsigned long long)iv->bytes,
+                     h->min_us / 1e3, hist_mean(h) / 1e3,
+                     hist_percentile(h, 50) / 1e3, hist_percentile(h, 99) / 1e3,
+                     h->max_us / 1e3, jitter_us / 1e3);
+
+    hist_init(&iv->hist);
+    iv->bytes = 0;
+    iv->start_us = end_us;
+    return n;
+}
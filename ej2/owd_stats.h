@@ -0,0 +1,66 @@
+// owd_stats.h
+// Histograma de retardos (log-lineal, ~1.5% de error relativo) y percentiles
+#ifndef OWD_STATS_H
+#define OWD_STATS_H
+
+#include <stdint.h>
+
+// Valores < 128 us exactos; luego 64 sub-buckets por potencia de 2 hasta 2^40 us
+#define HIST_SUB_BITS 6
+#define HIST_SUB      (1 << HIST_SUB_BITS)
+#define HIST_MAX_BITS 40
+#define HIST_BUCKETS  (2 * HIST_SUB + (HIST_MAX_BITS - HIST_SUB_BITS) * HIST_SUB)
+
+typedef struct {
+    uint64_t count;
+    int64_t  min_us, max_us;   // extremos reales (pueden ser negativos sin NTP)
+    double   sum_us;
+    uint64_t buckets[HIST_BUCKETS];
+} owd_hist_t;
+
+void    hist_init(owd_hist_t *h);
+// Los retardos negativos (relojes desfasados) se acumulan en el bucket 0
+void    hist_add(owd_hist_t *h, int64_t delay_us);
+void    hist_merge(owd_hist_t *dst, const owd_hist_t *src);
+// p en [0, 100]; devuelve el retardo en us (0 si está vacío)
+int64_t hist_percentile(const owd_hist_t *h, double p);
+double  hist_mean(const owd_hist_t *h);
+// Corrección de coordinated omission: las `missed` ranuras omitidas justo
+// antes de una muestra con retardo value_us habrían esperado value_us + k*period.
+// Se suman por bucket (no una por una) y como mucho HIST_OMITTED_MAX_US de
+// hueco: missed viene del par. Devuelve cuántas agregó.
+#define HIST_OMITTED_MAX_US 3600000000LL   // una hora
+uint64_t hist_add_omitted(owd_hist_t *h, int64_t value_us, int64_t period_us,
+                          uint64_t missed);
+
+// Variación de retardo, calculada PDU a PDU. Todas las métricas son
+// diferencias de retardos, así que el desfasaje entre relojes se cancela.
+//   jitter: interarrival jitter de RFC 3550 (J += (|D(i-1,i)| - J) / 16)
+//   ipdv:   D(i) - D(i-1) (RFC 3393)
+//   pdv:    D(i) - min D  (RFC 5481; en vivo, contra el mínimo visto hasta ahora)
+typedef struct {
+    int        have_prev;
+    int64_t    prev_delay_us;
+    int64_t    min_delay_us;
+    double     jitter_us;
+    owd_hist_t ipdv_abs;      // distribución de |IPDV|
+} owd_pdv_t;
+
+void pdv_init(owd_pdv_t *v);
+void pdv_add(owd_pdv_t *v, int64_t delay_us, int64_t *ipdv_us, int64_t *pdv_us);
+
+// Agregado por intervalo (modo monitoreo en vivo del servidor)
+typedef struct {
+    uint64_t   start_us, interval_us;
+    uint64_t   bytes;
+    owd_hist_t hist;
+} owd_interval_t;
+
+void interval_init(owd_interval_t *iv, uint64_t start_us, int interval_ms);
+void interval_add(owd_interval_t *iv, int64_t delay_us, size_t bytes);
+// Escribe una línea "clave=valor" con el agregado (jitter = RFC 3550 al
+// cierre del intervalo) y arranca el próximo intervalo
+int  interval_flush(owd_interval_t *iv, uint64_t t0_us, uint64_t end_us,
+                    double jitter_us, char *line, size_t len);
+
+#endif
@@ -0,0 +1,138 @@
+// probe.h
+// Definiciones compartidas por los clientes/servidores de sondas OWD (TCP y UDP)
+#ifndef PROBE_H
+#define PROBE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+
+#define SERVER_PORT      20252   // sondas TCP
+#define UDP_PROBE_PORT   20253   // sondas UDP (20252/udp lo usa el servidor de ej1)
+#define BULK_PORT        20254   // flujos de carga masiva (modo throughput)
+#define CTRL_PORT        20255   // canal de control (inicio sincronizado)
+#define MIN_PAYLOAD_SIZE 500
+#define MAX_PAYLOAD_SIZE 1000
+
+// PDU TCP: 8 bytes timestamp (us, orden del host) + payload + '|'
+#define TS_LEN      8
+#define PDU_DELIM   '|'
+#define MIN_PDU_LEN (TS_LEN + MIN_PAYLOAD_SIZE + 1)
+#define MAX_PDU_LEN (TS_LEN + MAX_PAYLOAD_SIZE + 1)
+
+// PDU UDP: mismo timestamp + 4 bytes de secuencia + payload + '|'
+// (un datagrama por PDU, el '|' se mantiene para reutilizar el formato)
+#define SEQ_LEN         4
+#define UDP_HDR_LEN     (TS_LEN + SEQ_LEN)
+#define UDP_MIN_PDU_LEN (UDP_HDR_LEN + MIN_PAYLOAD_SIZE + 1)
+#define UDP_MAX_PDU_LEN (UDP_HDR_LEN + MAX_PAYLOAD_SIZE + 1)
+#define UDP_SEQ_END     0xFFFFFFFFu // marca de fin de prueba (sin payload)
+
+// Convierte gettimeofday() a microsegundos desde epoch
+static inline uint64_t now_us(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (uint64_t)tv.tv_sec * 1000000ULL + (uint64_t)tv.tv_usec;
+}
+
+// Envía todo el buffer por TCP (maneja partial sends)
+static inline int send_all(int sockfd, const void *buf, size_t len) {
+    const char *p = buf;
+    size_t sent = 0;
+    while (sent < len) {
+        ssize_t n = send(sockfd, p + sent, len - sent, 0);
+        if (n <= 0) {
+            return -1;
+        }
+        sent += (size_t)n;
+    }
+    return 0;
+}
+
+// Arma una PDU TCP en buf (de al menos MAX_PDU_LEN bytes). Devuelve su largo.
+static inline size_t build_tcp_pdu(char *buf, uint64_t origin_ts_us, int payload_len) {
+    memcpy(buf, &origin_ts_us, TS_LEN);
+    memset(buf + TS_LEN, 0x20, (size_t)payload_len);  // payload = espacios
+    buf[TS_LEN + payload_len] = PDU_DELIM;
+    return TS_LEN + (size_t)payload_len + 1;
+}
+
+// Marca de planificación en el payload (ASCII, nunca contiene '|'):
+//   "co:<envio_previsto_us>:<periodo_us>;" seguido de los espacios de relleno.
+// Permite al servidor detectar ranuras omitidas (coordinated omission).
+// Las PDUs sin marca (clientes viejos) siguen siendo válidas.
+#define SCHED_TAG_PREFIX "co:"
+
+// `extra` (opcional) se agrega después de la marca, p.ej. la marca de fase.
+static inline size_t build_tcp_pdu_sched(char *buf, uint64_t origin_ts_us,
+                                         uint64_t intended_us, uint64_t period_us,
+                                         int payload_len, const char *extra) {
+    size_t len = build_tcp_pdu(buf, origin_ts_us, payload_len);
+    char tag[128];
+    int n = snprintf(tag, sizeof(tag), SCHED_TAG_PREFIX "%llu:%llu;%s",
+                     (unsigned long long)intended_us, (unsigned long long)period_us,
+                     extra ? extra : "");
+    if (n > 0 && n < payload_len) memcpy(buf + TS_LEN, tag, (size_t)n);
+    return len;
+}
+
+// Devuelve 1 si el payload trae la marca de planificación
+static inline int parse_sched_tag(const char *payload, int len,
+                                  uint64_t *intended_us, uint64_t *period_us) {
+    const int plen = (int)sizeof(SCHED_TAG_PREFIX) - 1;
+    if (len < plen || memcmp(payload, SCHED_TAG_PREFIX, (size_t)plen) != 0) return 0;
+
+    uint64_t v[2] = { 0, 0 };
+    int i = plen;
+    for (int k = 0; k < 2; k++) {
+        int digits = 0;
+        while (i < len && payload[i] >= '0' && payload[i] <= '9') {
+            v[k] = v[k] * 10 + (uint64_t)(payload[i++] - '0');
+            digits++;
+        }
+        char sep = k == 0 ? ':' : ';';
+        if (digits == 0 || i >= len || payload[i] != sep) return 0;
+        i++;
+    }
+    if (v[1] == 0) return 0;
+    *intended_us = v[0];
+    *period_us = v[1];
+    return 1;
+}
+
+// Marca de fase del modo barrido (tcp_client -S), a continuación de la de
+// planificación: "ph:<id>/<total>,<delay_ms>,<payload_min>-<payload_max>,<conexiones>;"
+// El servidor agrupa las muestras por fase y arma la matriz de resultados.
+#define PHASE_TAG_PREFIX "ph:"
+#define MAX_PHASES 256          // fases por barrido
+
+typedef struct {
+    int id, total;
+    int delay_ms, payload_min, payload_max, conns;
+} phase_tag_t;
+
+static inline int format_phase_tag(char *buf, size_t len, const phase_tag_t *ph) {
+    return snprintf(buf, len, PHASE_TAG_PREFIX "%d/%d,%d,%d-%d,%d;", ph->id, ph->total,
+                    ph->delay_ms, ph->payload_min, ph->payload_max, ph->conns);
+}
+
+// Devuelve 1 si el payload trae la marca de fase
+static inline int parse_phase_tag(const char *payload, int len, phase_tag_t *ph) {
+    char tmp[160];
+    int n = len < (int)sizeof(tmp) - 1 ? len : (int)sizeof(tmp) - 1;
+    memcpy(tmp, payload, (size_t)n);
+    tmp[n] = '\0';
+    const char *p = strstr(tmp, PHASE_TAG_PREFIX);
+    if (!p) return 0;
+    if (sscanf(p, PHASE_TAG_PREFIX "%d/%d,%d,%d-%d,%d;", &ph->id, &ph->total,
+               &ph->delay_ms, &ph->payload_min, &ph->payload_max, &ph->conns) != 6) {
+        return 0;
+    }
+    return ph->id >= 0 && ph->id < ph->total;
+}
+
+#endif
@@ -4,126 +4,415 @@
 #include <stdint.h>
 #include <string.h>
 #include <unistd.h>
+#include <pthread.h>
 #include <arpa/inet.h>
 #include <sys/time.h>
+#include "probe.h"
+#include "bulk.h"
+#include "ctrl.h"
+#include "mptcp_stats.h"
 
-#define SERVER_PORT      20252
-#define MIN_PAYLOAD_SIZE 500
-#define MAX_PAYLOAD_SIZE 1000
+#define MAX_LOAD_FLOWS 64
+#define MAX_SWEEP_VALS 16    // valores por dimensión del barrido
+#define MAX_SWEEP_CONNS 64   // conexiones simultáneas por fase
 
-static uint64_t now_us(void) {
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-    return (uint64_t)tv.tv_sec * 1000000ULL + (uint64_t)tv.tv_usec;
+// Flujo de carga del modo -L (latencia bajo carga)
+typedef struct {
+    struct sockaddr_in addr;
+    bulk_opts_t opts;
+    uint64_t start_us;      // el flujo espera hasta este instante
+    pthread_t thread;
+} load_flow_t;
+
+// Una conexión de sonda (el modo normal usa una; el barrido, varias por fase)
+typedef struct {
+    struct sockaddr_in addr;
+    int delay_ms;
+    int payload_min, payload_max;
+    uint64_t start_us, duration_us;
+    char tag[64];           // marca de fase ("" fuera del barrido)
+    unsigned int seed;
+    uint64_t sent, missed;  // resultados
+    int failed;
+    pthread_t thread;
+} probe_run_t;
+
+static int use_mptcp;   // -M: todas las conexiones de datos por MPTCP
+
+static int connect_to(const struct sockaddr_in *addr) {
+    int fd = mptcp_socket(use_mptcp);
+    if (fd < 0) {
+        perror("socket");
+        return -1;
+    }
+    if (connect(fd, (const struct sockaddr *)addr, sizeof(*addr)) < 0) {
+        perror("connect");
+        close(fd);
+        return -1;
+    }
+    return fd;
 }
 
-// Envía todo el buffer por TCP (maneja partial sends)
-static int send_all(int sockfd, const void *buf, size_t len) {
-    const char *p = buf;
-    size_t sent = 0;
-    while (sent < len) {
-        ssize_t n = send(sockfd, p + sent, len - sent, 0);
-        if (n <= 0) {
+static void *load_flow_thread(void *arg) {
+    load_flow_t *f = arg;
+    uint64_t t = now_us();
+    if (f->start_us > t) usleep((unsigned int)(f->start_us - t));
+
+    int fd = connect_to(&f->addr);
+    if (fd < 0) return NULL;
+    bulk_send(fd, &f->opts, NULL);
+    close(fd);
+    return NULL;
+}
+
+// Envía sondas por sockfd durante r->duration_us a partir de r->start_us
+static int run_probe(int sockfd, probe_run_t *r) {
+    // buffer suficientemente grande para la PDU máxima
+    char pdu[MAX_PDU_LEN];
+
+    // Envíos sobre una grilla fija (ranura k en start + k*periodo). Si un
+    // send_all() bloqueado hace pasar ranuras, se saltean y se informan: así el
+    // servidor sabe qué sondas faltan en vez de que la pausa desaparezca.
+    uint64_t period_us = (uint64_t)r->delay_ms * 1000ULL;
+    uint64_t slot = 0;
+
+    // con inicio sincronizado (-w) la conexión ya está hecha y se espera acá
+    uint64_t t0 = now_us();
+    if (r->start_us > t0) usleep((unsigned int)(r->start_us - t0));
+
+    while (1) {
+        uint64_t t_now = now_us();
+        if (t_now - r->start_us >= r->duration_us) {
+            break; // terminó la prueba
+        }
+
+        uint64_t due = (t_now - r->start_us) / period_us; // última ranura vencida
+        if (due > slot) {
+            r->missed += due - slot;
+            slot = due;
+        }
+
+        uint64_t origin_ts_us = t_now;
+        uint64_t intended_us = r->start_us + slot * period_us;
+
+        // elegir tamaño de payload en [payload_min, payload_max]
+        int payload_len = r->payload_min +
+            (int)(rand_r(&r->seed) % (unsigned)(r->payload_max - r->payload_min + 1));
+
+        // armar PDU: 8 bytes timestamp + payload (con marcas) + '|'
+        size_t pdu_len = build_tcp_pdu_sched(pdu, origin_ts_us, intended_us,
+                                             period_us, payload_len, r->tag);
+
+        if (send_all(sockfd, pdu, pdu_len) < 0) {
+            perror("send_all");
             return -1;
         }
-        sent += (size_t)n;
+        r->sent++;
+
+        // esperar hasta la próxima ranura
+        slot++;
+        uint64_t next_us = r->start_us + slot * period_us;
+        uint64_t t_after = now_us();
+        if (next_us > t_after) {
+            usleep((unsigned int)(next_us - t_after));
+        }
     }
     return 0;
 }
 
+static void *probe_thread(void *arg) {
+    probe_run_t *r = arg;
+    int fd = connect_to(&r->addr);
+    if (fd < 0) {
+        r->failed = 1;
+        return NULL;
+    }
+    if (run_probe(fd, r) < 0) r->failed = 1;
+    close(fd);
+    return NULL;
+}
+
+// Parsea "a,b,c" (o rangos "a-b,c-d" si hi != NULL). Devuelve la cantidad.
+static int parse_list(const char *s, int *lo, int *hi) {
+    int n = 0;
+    char tmp[256];
+    snprintf(tmp, sizeof(tmp), "%s", s);
+    for (char *save, *tok = strtok_r(tmp, ",", &save); tok && n < MAX_SWEEP_VALS;
+         tok = strtok_r(NULL, ",", &save)) {
+        lo[n] = atoi(tok);
+        if (hi) {
+            char *dash = strchr(tok, '-');
+            hi[n] = dash ? atoi(dash + 1) : lo[n];
+        }
+        n++;
+    }
+    return n;
+}
+
+// Modo -S: recorre la matriz delays x rangos de payload x conexiones, una fase
+// de duration_s por combinación. Cada PDU lleva la marca de su fase. La primera
+// fase arranca en start_us (0 = ya).
+static int run_sweep(const struct sockaddr_in *addr, const char *delays,
+                     const char *payloads, const char *conns, int duration_s,
+                     uint64_t start_us) {
+    int d[MAX_SWEEP_VALS], pmin[MAX_SWEEP_VALS], pmax[MAX_SWEEP_VALS], c[MAX_SWEEP_VALS];
+    int nd = parse_list(delays, d, NULL);
+    int np = parse_list(payloads, pmin, pmax);
+    int nc = parse_list(conns, c, NULL);
+
+    if (nd == 0 || np == 0 || nc == 0) return -1;
+    for (int i = 0; i < nd; i++) {
+        if (d[i] <= 0) return -1;
+    }
+    for (int i = 0; i < np; i++) {
+        if (pmin[i] < MIN_PAYLOAD_SIZE || pmax[i] > MAX_PAYLOAD_SIZE || pmin[i] > pmax[i]) {
+            fprintf(stderr, "Rango de payload inválido (%d-%d), debe estar en %d-%d\n",
+                    pmin[i], pmax[i], MIN_PAYLOAD_SIZE, MAX_PAYLOAD_SIZE);
+            return -1;
+        }
+    }
+    for (int i = 0; i < nc; i++) {
+        if (c[i] <= 0 || c[i] > MAX_SWEEP_CONNS) return -1;
+    }
+
+    int total = nd * np * nc;
+    if (total > MAX_PHASES) {
+        fprintf(stderr, "Demasiadas fases (%d, máximo %d)\n", total, MAX_PHASES);
+        return -1;
+    }
+    printf("Barrido: %d fases de %d s (%d delays x %d payloads x %d conexiones)\n",
+           total, duration_s, nd, np, nc);
+
+    static probe_run_t runs[MAX_SWEEP_CONNS];
+    int phase = 0, failed = 0;
+    for (int id = 0; id < nd; id++) {
+        for (int ip = 0; ip < np; ip++) {
+            for (int ic = 0; ic < nc; ic++, phase++) {
+                phase_tag_t tag = { phase, total, d[id], pmin[ip], pmax[ip], c[ic] };
+                if (phase > 0 || start_us == 0) start_us = now_us();
+                for (int k = 0; k < c[ic]; k++) {
+                    probe_run_t *r = &runs[k];
+                    memset(r, 0, sizeof(*r));
+                    r->addr = *addr;
+                    r->delay_ms = d[id];
+                    r->payload_min = pmin[ip];
+                    r->payload_max = pmax[ip];
+                    r->start_us = start_us;
+                    r->duration_us = (uint64_t)duration_s * 1000000ULL;
+                    r->seed = (unsigned int)((start_us + (uint64_t)k) ^ (uint64_t)getpid());
+                    format_phase_tag(r->tag, sizeof(r->tag), &tag);
+                    pthread_create(&r->thread, NULL, probe_thread, r);
+                }
+                uint64_t sent = 0, missed = 0;
+                for (int k = 0; k < c[ic]; k++) {
+                    pthread_join(runs[k].thread, NULL);
+                    sent += runs[k].sent;
+                    missed += runs[k].missed;
+                    failed |= runs[k].failed;
+                }
+                printf("Fase %d/%d: delay=%d ms payload=%d-%d conexiones=%d "
+                       "sondas=%llu omitidas=%llu\n", phase + 1, total, d[id],
+                       pmin[ip], pmax[ip], c[ic], (unsigned long long)sent,
+                       (unsigned long long)missed);
+            }
+        }
+    }
+    return failed ? -1 : 0;
+}
+
 int main(int argc, char *argv[]) {
     if (argc < 5) {
         fprintf(stderr,
-                "Uso: %s <IP Servidor> -d <delay_ms> -N <duracion_s>\n",
-                argv[0]);
+                "Uso: %s <IP Servidor> -d <delay_ms> -N <duracion_s>\n"
+                "     %s <IP Servidor> -B -N <duracion_s> [-f archivo] [-z] [-i intervalo_ms]\n"
+                "     %s <IP Servidor> -S -d <d1,d2,..> [-P <min-max,..>] [-c <c1,c2,..>] -N <s>\n"
+                "  -B  modo throughput: flujo masivo hacia tcp_server -B\n"
+                "  -f  enviar el archivo con sendfile() (en bucle) en vez de ceros\n"
+                "  -F <archivo>  modo throughput enviando el archivo una sola vez\n"
+                "      (transferencia de archivo; -N no hace falta)\n"
+                "  -z  enviar el buffer de ceros con MSG_ZEROCOPY\n"
+                "  -L <flujos>  latencia bajo carga (con tcp_server -L): la primera\n"
+                "      mitad de la prueba mide en reposo y la segunda con <flujos>\n"
+                "      flujos masivos saturando el camino\n"
+                "  -S  barrido: una fase de -N segundos por cada combinación de delay,\n"
+                "      rango de payload (-P, por defecto %d-%d) y cantidad de\n"
+                "      conexiones simultáneas (-c, por defecto 1); tcp_server arma\n"
+                "      la matriz de resultados (owd_matrix.csv)\n"
+                "  -w  registrarse en el canal de control (puerto %d, tcp_server -w)\n"
+                "      y empezar a enviar en el instante que fija el servidor\n"
+                "  -M  conectar por MPTCP (vuelve a TCP si no hay soporte) e informar\n"
+                "      RTT, cwnd y retransmisiones de cada subflujo al terminar\n",
+                argv[0], argv[0], argv[0], MIN_PAYLOAD_SIZE, MAX_PAYLOAD_SIZE, CTRL_PORT);
         return EXIT_FAILURE;
     }
 
     const char *server_ip = argv[1];
+    const char *delay_arg = NULL;
+    const char *payload_arg = NULL;
+    const char *conns_arg = "1";
     int delay_ms = -1;
     int duration_s = -1;
+    int bulk = 0;
+    int sweep = 0;
+    int load_flows = 0;
+    int wait_start = 0;
+    bulk_opts_t bulk_opts = { NULL, 0, 0, BULK_INTERVAL_MS, 0 };
 
     // parseo simple de -d y -N
     for (int i = 2; i < argc; i++) {
         if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
-            delay_ms = atoi(argv[++i]);
+            delay_arg = argv[++i];
+            delay_ms = atoi(delay_arg);
         } else if (strcmp(argv[i], "-N") == 0 && i + 1 < argc) {
             duration_s = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-B") == 0) {
+            bulk = 1;
+        } else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+            bulk_opts.file = argv[++i];
+        } else if (strcmp(argv[i], "-F") == 0 && i + 1 < argc) {
+            bulk = 1;
+            bulk_opts.file = argv[++i];
+            bulk_opts.once = 1;
+        } else if (strcmp(argv[i], "-z") == 0) {
+            bulk_opts.zerocopy = 1;
+        } else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+            bulk_opts.interval_ms = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-L") == 0 && i + 1 < argc) {
+            load_flows = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-S") == 0) {
+            sweep = 1;
+        } else if (strcmp(argv[i], "-P") == 0 && i + 1 < argc) {
+            payload_arg = argv[++i];
+        } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            conns_arg = argv[++i];
+        } else if (strcmp(argv[i], "-w") == 0) {
+            wait_start = 1;
+        } else if (strcmp(argv[i], "-M") == 0) {
+            use_mptcp = 1;
         }
     }
 
-    if (delay_ms <= 0 || duration_s <= 0) {
+    if ((!bulk && delay_ms <= 0) || (duration_s <= 0 && !bulk_opts.once) ||
+        load_flows < 0 || load_flows > MAX_LOAD_FLOWS) {
         fprintf(stderr,
                 "Parámetros inválidos. Ejemplo: %s 192.168.20.144 -d 50 -N 10\n",
                 argv[0]);
         return EXIT_FAILURE;
     }
 
-    int sockfd;
+    int sockfd = -1;
     struct sockaddr_in serv_addr;
 
-    if ((sockfd = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
-        perror("socket");
-        return EXIT_FAILURE;
-    }
-
     memset(&serv_addr, 0, sizeof(serv_addr));
     serv_addr.sin_family = AF_INET;
-    serv_addr.sin_port   = htons(SERVER_PORT);
+    serv_addr.sin_port   = htons(bulk ? BULK_PORT : SERVER_PORT);
 
     if (inet_pton(AF_INET, server_ip, &serv_addr.sin_addr) <= 0) {
         perror("inet_pton");
-        close(sockfd);
         return EXIT_FAILURE;
     }
 
-    if (connect(sockfd, (struct sockaddr *)&serv_addr, sizeof(serv_addr)) < 0) {
-        perror("connect");
-        close(sockfd);
+    // Con -w la conexión de sonda se abre antes de registrarse: al llegar el
+    // inicio sólo queda esperar el instante acordado
+    uint64_t epoch_us = 0;
+    if (!bulk && !sweep && (sockfd = connect_to(&serv_addr)) < 0) {
         return EXIT_FAILURE;
     }
+    if (wait_start && !bulk) {
+        struct sockaddr_in ctrl_addr = serv_addr;
+        int idx, n;
+        ctrl_addr.sin_port = htons(CTRL_PORT);
+        printf("Esperando el inicio sincronizado...\n");
+        if (ctrl_wait_start(&ctrl_addr, &epoch_us, &idx, &n) < 0) {
+            if (sockfd >= 0) close(sockfd);
+            return EXIT_FAILURE;
+        }
+        printf("Cliente %d/%d: inicio en %.3f s\n", idx + 1, n,
+               epoch_us > now_us() ? (double)(epoch_us - now_us()) / 1e6 : 0.0);
+    }
 
-    printf("Conectado a %s:%d. delay=%d ms, duracion=%d s\n",
-           server_ip, SERVER_PORT, delay_ms, duration_s);
-
-    uint64_t start_us = now_us();
-    uint64_t duration_us = (uint64_t)duration_s * 1000000ULL;
-
-    // buffer suficientemente grande para la PDU máxima
-    char pdu[8 + MAX_PAYLOAD_SIZE + 1];
-
-    // inicializar random
-    srand((unsigned int)start_us);
-
-    while (1) {
-        uint64_t t_now = now_us();
-        if (t_now - start_us >= duration_us) {
-            break; // terminó la prueba
+    if (sweep) {
+        char range[32];
+        snprintf(range, sizeof(range), "%d-%d", MIN_PAYLOAD_SIZE, MAX_PAYLOAD_SIZE);
+        if (run_sweep(&serv_addr, delay_arg, payload_arg ? payload_arg : range,
+                      conns_arg, duration_s, epoch_us) < 0) {
+            fprintf(stderr, "Barrido incompleto o parámetros inválidos\n");
+            return EXIT_FAILURE;
         }
+        return EXIT_SUCCESS;
+    }
 
-        uint64_t origin_ts_us = t_now;
+    if (bulk) {
+        if ((sockfd = connect_to(&serv_addr)) < 0) {
+            return EXIT_FAILURE;
+        }
+        if (bulk_opts.once) {
+            printf("Conectado a %s:%d. enviando %s (una vez)\n", server_ip, BULK_PORT,
+                   bulk_opts.file);
+        } else {
+            printf("Conectado a %s:%d. modo throughput (%s), duracion=%d s\n",
+                   server_ip, BULK_PORT,
+                   bulk_opts.file ? "sendfile" : bulk_opts.zerocopy ? "MSG_ZEROCOPY" : "send",
+                   duration_s);
+        }
+        bulk_opts.duration_s = duration_s;
+        int64_t sent = bulk_send(sockfd, &bulk_opts, "bulk tx");
+        if (use_mptcp) {
+            mptcp_snapshot_t snap;
+            mptcp_snapshot(sockfd, &snap);
+            mptcp_print(&snap, "bulk tx");
+        }
+        close(sockfd);
+        return sent < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
 
-        // elegir tamaño de payload entre 500 y 1000
-        int payload_len = MIN_PAYLOAD_SIZE +
-            rand() % (MAX_PAYLOAD_SIZE - MIN_PAYLOAD_SIZE + 1);
+    printf("Conectado a %s:%d. delay=%d ms, duracion=%d s\n",
+           server_ip, SERVER_PORT, delay_ms, duration_s);
 
-        // armar PDU: 8 bytes timestamp + payload + '|'
-        memcpy(pdu, &origin_ts_us, sizeof(uint64_t));
-        memset(pdu + 8, 0x20, payload_len);  // payload = espacios
-        pdu[8 + payload_len] = '|';
+    probe_run_t run;
+    memset(&run, 0, sizeof(run));
+    run.delay_ms = delay_ms;
+    run.payload_min = MIN_PAYLOAD_SIZE;
+    run.payload_max = MAX_PAYLOAD_SIZE;
+    run.start_us = epoch_us ? epoch_us : now_us();
+    run.duration_us = (uint64_t)duration_s * 1000000ULL;
+    // inicializar random
+    run.seed = (unsigned int)(run.start_us ^ (uint64_t)getpid());
 
-        size_t pdu_len = 8 + (size_t)payload_len + 1;
+    // Modo -L: los flujos de carga arrancan a mitad de la prueba
+    static load_flow_t flows[MAX_LOAD_FLOWS];
+    uint64_t load_start_us = run.start_us + run.duration_us / 2;
+    for (int f = 0; f < load_flows; f++) {
+        flows[f].addr = serv_addr;
+        flows[f].addr.sin_port = htons(BULK_PORT);
+        flows[f].opts = bulk_opts;
+        flows[f].opts.interval_ms = 0;
+        flows[f].opts.duration_s = (duration_s + 1) / 2;
+        flows[f].start_us = load_start_us;
+        pthread_create(&flows[f].thread, NULL, load_flow_thread, &flows[f]);
+    }
+    if (load_flows > 0) {
+        printf("%d flujos de carga a partir de t=%.1f s\n", load_flows,
+               (double)(run.duration_us / 2) / 1e6);
+    }
 
-        if (send_all(sockfd, pdu, pdu_len) < 0) {
-            perror("send_all");
-            break;
-        }
+    if (sockfd < 0) return EXIT_FAILURE;
+    run_probe(sockfd, &run);
 
-        // esperar d ms
-        usleep((unsigned int)delay_ms * 1000U);
+    if (run.missed > 0) {
+        printf("Ranuras omitidas por envíos bloqueados: %llu\n",
+               (unsigned long long)run.missed);
+    }
 
+    // Vista del emisor: el RTT de cada subflujo sale de sus propios ACKs
+    if (use_mptcp) {
+        mptcp_snapshot_t snap;
+        mptcp_snapshot(sockfd, &snap);
+        mptcp_print(&snap, "tcp tx");
     }
 
+    // Esperar a la carga antes de cerrar la sonda: al cerrarla el servidor termina
+    for (int f = 0; f < load_flows; f++) pthread_join(flows[f].thread, NULL);
     close(sockfd);
     return EXIT_SUCCESS;
 }
@@ -4,142 +4,1048 @@
 #include <stdint.h>
 #include <string.h>
 #include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <arpa/inet.h>
 #include <sys/time.h>
+#include <linux/net_tstamp.h>
+#include <linux/errqueue.h>
+#include "probe.h"
+#include "bulk.h"
+#include "owd_stats.h"
+#include "monitor.h"
+#include "csv_log.h"
+#include "ctrl.h"
+#include "mptcp_stats.h"
 
-#define SERVER_PORT 20252
 #define BUF_SIZE    4096
 
-// Convierte gettimeofday() a microsegundos desde epoch
-static uint64_t now_us(void) {
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-    return (uint64_t)tv.tv_sec * 1000000ULL + (uint64_t)tv.tv_usec;
-}
-
-int main(void) {
-    int listenfd, connfd;
-    struct sockaddr_in serv_addr, cli_addr;
-    socklen_t cli_len = sizeof(cli_addr);
+// Modo -L: cantidad de flujos masivos activos mientras se mide la sonda
+static atomic_int active_bulk;
 
-    // 1) Crear socket TCP
-    if ((listenfd = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
+// Crea un socket TCP escuchando en el puerto dado (o -1 ante error). Con
+// reuseport varios sockets comparten el puerto y el kernel reparte las conexiones.
+// Con mptcp se aceptan conexiones MPTCP (y también TCP común, por fallback).
+static int listen_on(int port, int backlog, int reuseport, int mptcp) {
+    struct sockaddr_in addr;
+    int fd = mptcp_socket(mptcp);
+    if (fd < 0) {
         perror("socket");
-        exit(EXIT_FAILURE);
+        return -1;
     }
 
     int opt = 1;
-    setsockopt(listenfd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    if (reuseport && setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0) {
+        perror("SO_REUSEPORT");
+        close(fd);
+        return -1;
+    }
 
-    memset(&serv_addr, 0, sizeof(serv_addr));
-    serv_addr.sin_family      = AF_INET;
-    serv_addr.sin_addr.s_addr = INADDR_ANY;
-    serv_addr.sin_port        = htons(SERVER_PORT);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = INADDR_ANY;
+    addr.sin_port        = htons(port);
 
-    if (bind(listenfd, (struct sockaddr*)&serv_addr, sizeof(serv_addr)) < 0) {
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
         perror("bind");
-        close(listenfd);
-        exit(EXIT_FAILURE);
+        close(fd);
+        return -1;
     }
-
-    if (listen(listenfd, 1) < 0) {
+    if (listen(fd, backlog) < 0) {
         perror("listen");
-        close(listenfd);
-        exit(EXIT_FAILURE);
+        close(fd);
+        return -1;
     }
+    return fd;
+}
 
-    printf("Servidor TCP escuchando en puerto %d...\n", SERVER_PORT);
+static void *bulk_flow_thread(void *arg) {
+    int fd = (int)(intptr_t)arg;
+    bulk_sink(fd, 0, 0, NULL);
+    close(fd);
+    atomic_fetch_sub(&active_bulk, 1);
+    return NULL;
+}
 
-    connfd = accept(listenfd, (struct sockaddr*)&cli_addr, &cli_len);
-    if (connfd < 0) {
-        perror("accept");
-        close(listenfd);
-        exit(EXIT_FAILURE);
+// Acepta flujos de carga en BULK_PORT y los descarta, uno por hilo
+static void *bulk_accept_thread(void *arg) {
+    int lfd = (int)(intptr_t)arg;
+    while (1) {
+        int fd = accept(lfd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        atomic_fetch_add(&active_bulk, 1);
+        pthread_t t;
+        if (pthread_create(&t, NULL, bulk_flow_thread, (void *)(intptr_t)fd) != 0) {
+            close(fd);
+            atomic_fetch_sub(&active_bulk, 1);
+            continue;
+        }
+        pthread_detach(t);
     }
-    printf("Cliente conectado.\n");
+    return NULL;
+}
 
-    FILE *csv = fopen("owd_results.csv", "w");
-    if (!csv) {
-        perror("fopen csv");
-        close(connfd);
-        close(listenfd);
-        exit(EXIT_FAILURE);
+// Tabla de percentiles en reposo vs. bajo carga (modo -L)
+static void print_load_report(const owd_hist_t *idle, const owd_hist_t *loaded) {
+    static const double pcts[] = { 50, 90, 99, 99.9, 100 };
+    printf("Latencia bajo carga: muestras reposo=%llu carga=%llu\n",
+           (unsigned long long)idle->count, (unsigned long long)loaded->count);
+    if (idle->count == 0 || loaded->count == 0) {
+        printf("  (faltan muestras en alguna fase, no se puede comparar)\n");
+        return;
     }
-    // podés dejar sin header si querés
-    fprintf(csv, "n,delay_s\n");
+    printf("  %-8s %12s %12s %12s\n", "", "reposo_ms", "carga_ms", "delta_ms");
+    printf("  %-8s %12.3f %12.3f %+12.3f\n", "media", hist_mean(idle) / 1e3,
+           hist_mean(loaded) / 1e3, (hist_mean(loaded) - hist_mean(idle)) / 1e3);
+    for (size_t i = 0; i < sizeof(pcts) / sizeof(pcts[0]); i++) {
+        char label[16];
+        if (pcts[i] >= 100) snprintf(label, sizeof(label), "max");
+        else snprintf(label, sizeof(label), "p%g", pcts[i]);
+        int64_t a = hist_percentile(idle, pcts[i]);
+        int64_t b = hist_percentile(loaded, pcts[i]);
+        printf("  %-8s %12.3f %12.3f %+12.3f\n", label, a / 1e3, b / 1e3, (b - a) / 1e3);
+    }
+}
 
-    char buf[BUF_SIZE];
-    int used = 0;          // bytes válidos en buf
-    int measurement = 0;   // contador de mediciones
+#define MAX_PROBE_CONNS 64
+#define MAX_WORKERS     64
+#define CSV_BATCH       8192   // bytes de filas que junta cada hilo antes de escribir
+#define CSV_HOLD_US     100000 // y lo más que las retiene con poco tráfico
+#define CO_MIN_PERIOD_US 1000 // período mínimo creíble en la marca de planificación
 
-    while (1) {
-        ssize_t n = read(connfd, buf + used, BUF_SIZE - used);
-        if (n < 0) {
-            perror("read");
+typedef struct {
+    int interval_ms;   // agregados en vivo (0 = deshabilitados)
+    int load;          // modo -L
+    int continuous;    // modo -C
+    int workers;       // hilos receptores (-j)
+    int busy;          // modo -b: hilos receptores girando sobre poll(0)
+    int busy_poll_us;  // SO_BUSY_POLL de cada conexión en modo -b
+    int rx_stamp;      // modo -q: medir kernel -> aplicación con SO_TIMESTAMPING
+    int mptcp;         // modo -M: sockets MPTCP y estadísticas por subflujo
+} probe_opts_t;
+
+// Estado de una conexión de sonda
+typedef struct {
+    int        fd;
+    char       buf[BUF_SIZE];
+    int        used;           // bytes válidos en buf
+    int        measurement;    // contador de mediciones
+    int        phase;          // fase del barrido (-1 si el cliente no la marca)
+    owd_hist_t h_all, h_idle, h_loaded;
+    // Coordinated omission: retardo medido desde el envío previsto (ranura)
+    // más las muestras sintéticas de las ranuras que el cliente no pudo enviar
+    owd_hist_t h_co;
+    uint64_t   prev_intended_us, missed_total;
+    int        sched_seen;
+    owd_pdv_t  pdv;
+    // Modo -q: demora desde que el kernel recibió los datos hasta el read(),
+    // en ns (lo que cuesta despertar al hilo; lo que el modo -b intenta recortar)
+    owd_hist_t h_rx;
+    int        id;             // número de conexión (columna conn de owd_mptcp.csv)
+    uint64_t   mptcp_next_us;  // próxima foto de los subflujos (modo -M)
+} probe_conn_t;
+
+// Resultados de una fase del barrido (tcp_client -S)
+typedef struct {
+    phase_tag_t tag;
+    int         open_conns;    // conexiones de la fase todavía abiertas
+    int         seen_conns;
+    uint64_t    missed;
+    owd_hist_t  h, h_co;
+    double      jitter_sum_us; // jitter RFC 3550 final de cada conexión
+} phase_stats_t;
+
+// Hilo receptor: su propio listener (SO_REUSEPORT con -j > 1), sus conexiones
+// y sus histogramas, sin compartir nada en el camino de cada PDU. El hilo
+// principal toma `lock` sólo para juntar los de todos al reportar.
+typedef struct {
+    int                 id, listenfd;
+    const probe_opts_t *opts;
+    pthread_mutex_t     lock;
+    probe_conn_t       *conns[MAX_PROBE_CONNS];
+    int                 active, accepted;
+    owd_interval_t      iv;          // sólo hist y bytes; el tiempo lo lleva el principal
+    phase_stats_t      *phases[MAX_PHASES];
+    int                 phases_total; // fases anunciadas por el cliente (0 = sin barrido)
+    char                rows[CSV_BATCH + 256];   // filas sin la columna n
+    size_t              rows_used;
+    uint64_t            flushed_us;
+    char                out[CSV_BATCH + 512];    // lote ya numerado
+    pthread_t           thread;
+} probe_worker_t;
+
+static probe_worker_t workers[MAX_WORKERS];
+
+static csv_log_t *csv_out;
+static pthread_mutex_t csv_lock = PTHREAD_MUTEX_INITIALIZER;
+static atomic_ullong csv_rows;  // última fila escrita en el CSV (continúa entre clientes)
+
+// Modo -M: una fila por subflujo y por período en owd_mptcp.csv; la columna n
+// es la última fila de owd_results.csv a ese momento, para cruzar con los retardos
+static FILE *mptcp_fp;
+static pthread_mutex_t mptcp_lock = PTHREAD_MUTEX_INITIALIZER;
+static atomic_int conn_ids;
+
+// SIGINT/SIGTERM: cerrar el CSV y archivar el último segmento antes de salir
+static volatile sig_atomic_t stop_requested;
+static atomic_int workers_stop;
+
+static void on_stop_signal(int sig) {
+    (void)sig;
+    stop_requested = 1;
+}
+
+static probe_conn_t *probe_conn_new(int fd) {
+    probe_conn_t *c = calloc(1, sizeof(*c));
+    if (!c) return NULL;
+    c->fd = fd;
+    c->phase = -1;
+    c->id = atomic_fetch_add(&conn_ids, 1);
+    hist_init(&c->h_all);
+    hist_init(&c->h_idle);
+    hist_init(&c->h_loaded);
+    hist_init(&c->h_co);
+    hist_init(&c->h_rx);
+    pdv_init(&c->pdv);
+    return c;
+}
+
+// Asocia la conexión a su fase la primera vez que aparece la marca
+static void attach_phase(probe_worker_t *w, probe_conn_t *c, const phase_tag_t *tag) {
+    if (tag->id < 0 || tag->id >= MAX_PHASES) return;
+    phase_stats_t *ph = w->phases[tag->id];
+    if (!ph) {
+        if (!(ph = calloc(1, sizeof(*ph)))) return;
+        ph->tag = *tag;
+        hist_init(&ph->h);
+        hist_init(&ph->h_co);
+        w->phases[tag->id] = ph;
+    }
+    ph->open_conns++;
+    ph->seen_conns++;
+    w->phases_total = tag->total;
+    c->phase = tag->id;
+}
+
+// Vuelca las filas acumuladas por el hilo al CSV compartido. La columna n se
+// pone acá, bajo csv_lock: así queda en orden en el archivo aunque haya
+// varios hilos, y owd_mptcp.csv puede cruzarse por n
+static void flush_rows(probe_worker_t *w) {
+    w->flushed_us = now_us();
+    if (w->rows_used == 0) return;
+    pthread_mutex_lock(&csv_lock);
+    size_t o = 0;
+    for (size_t i = 0; i < w->rows_used;) {
+        const char *row = w->rows + i;
+        size_t len = (size_t)((const char *)memchr(row, '\n', w->rows_used - i) - row) + 1;
+        if (o + len + 24 > sizeof(w->out)) {
+            csv_log_write(csv_out, w->out, o);
+            o = 0;
+        }
+        o += (size_t)sprintf(w->out + o, "%llu,",
+                             (unsigned long long)atomic_fetch_add(&csv_rows, 1) + 1);
+        memcpy(w->out + o, row, len);
+        o += len;
+        i += len;
+    }
+    csv_log_write(csv_out, w->out, o);
+    pthread_mutex_unlock(&csv_lock);
+    w->rows_used = 0;
+}
+
+// Registra una PDU completa buf[0 .. pdu_len-1]
+static void handle_pdu(probe_worker_t *w, probe_conn_t *c, const char *buf, int pdu_len) {
+    uint64_t origin_ts_us = 0;
+    memcpy(&origin_ts_us, buf, sizeof(uint64_t));
+
+    uint64_t dest_ts_us = now_us();
+    int64_t delay_us = (int64_t)(dest_ts_us - origin_ts_us);
+    double delay_s = (double)delay_us / 1e6;
+
+    int64_t ipdv_us, pdv_us;
+    pdv_add(&c->pdv, delay_us, &ipdv_us, &pdv_us);
+
+    if (c->phase < 0 && c->measurement == 0) {
+        phase_tag_t tag;
+        if (parse_phase_tag(buf + TS_LEN, pdu_len - TS_LEN - 1, &tag)) {
+            attach_phase(w, c, &tag);
+        }
+    }
+    phase_stats_t *ph = c->phase >= 0 ? w->phases[c->phase] : NULL;
+
+    uint64_t intended_us, period_us, missed = 0;
+    int64_t sched_delay_us = delay_us;
+    // el cliente envía cada delay_ms entero: un período menor no es de él
+    if (parse_sched_tag(buf + TS_LEN, pdu_len - TS_LEN - 1, &intended_us, &period_us) &&
+        period_us >= CO_MIN_PERIOD_US) {
+        sched_delay_us = (int64_t)(dest_ts_us - intended_us);
+        if (c->sched_seen && intended_us > c->prev_intended_us + period_us) {
+            missed = (intended_us - c->prev_intended_us) / period_us - 1;
+            missed = hist_add_omitted(&c->h_co, sched_delay_us, (int64_t)period_us, missed);
+            if (ph) hist_add_omitted(&ph->h_co, sched_delay_us, (int64_t)period_us, missed);
+            c->missed_total += missed;
+        }
+        c->prev_intended_us = intended_us;
+        c->sched_seen = 1;
+    }
+    hist_add(&c->h_co, sched_delay_us);
+
+    c->measurement++;
+    hist_add(&c->h_all, delay_us);
+    interval_add(&w->iv, delay_us, (size_t)pdu_len);
+    if (ph) {
+        hist_add(&ph->h, delay_us);
+        hist_add(&ph->h_co, sched_delay_us);
+        ph->missed += missed;
+    }
+
+    // Con varios hilos las filas quedan intercaladas por lotes; n lo pone flush_rows
+    char *row = w->rows + w->rows_used;
+    size_t room = sizeof(w->rows) - w->rows_used;
+    int len = snprintf(row, room, "%.6f,%.6f,%.6f,%.6f,%.6f,%llu,%d", delay_s, ipdv_us / 1e6,
+                       pdv_us / 1e6, c->pdv.jitter_us / 1e6, sched_delay_us / 1e6,
+                       (unsigned long long)missed, c->phase);
+    if (w->opts->load) {
+        int flows = atomic_load(&active_bulk);
+        hist_add(flows > 0 ? &c->h_loaded : &c->h_idle, delay_us);
+        len += snprintf(row + len, room - (size_t)len, ",%d", flows);
+    }
+    row[len++] = '\n';
+    w->rows_used += (size_t)len;
+    if (w->rows_used >= CSV_BATCH) flush_rows(w);
+}
+
+// read() que además anota en h_rx cuánto tardó en llegar a la aplicación el
+// último segmento leído (marca de recepción por software del kernel)
+static ssize_t read_stamped(probe_conn_t *c, char *dst, size_t len) {
+    char ctrl[CMSG_SPACE(sizeof(struct scm_timestamping))];
+    struct iovec iov = { dst, len };
+    struct msghdr msg = { 0 };
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = ctrl;
+    msg.msg_controllen = sizeof(ctrl);
+
+    ssize_t n = recvmsg(c->fd, &msg, 0);
+    if (n <= 0) return n;
+
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    for (struct cmsghdr *cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm)) {
+        if (cm->cmsg_level != SOL_SOCKET || cm->cmsg_type != SCM_TIMESTAMPING) continue;
+        struct scm_timestamping ts;
+        memcpy(&ts, CMSG_DATA(cm), sizeof(ts));
+        if (ts.ts[0].tv_sec == 0) continue;
+        hist_add(&c->h_rx, (int64_t)(now.tv_sec - ts.ts[0].tv_sec) * 1000000000LL +
+                           (now.tv_nsec - ts.ts[0].tv_nsec));
+    }
+    return n;
+}
+
+// Lee lo disponible en la conexión y procesa las PDUs completas.
+// Devuelve 0 si la conexión sigue abierta, -1 si se cerró.
+static int probe_conn_read(probe_worker_t *w, probe_conn_t *c) {
+    char *buf = c->buf;
+    ssize_t n;
+
+    if (w->opts->rx_stamp) {
+        n = read_stamped(c, buf + c->used, BUF_SIZE - c->used);
+    } else {
+        n = read(c->fd, buf + c->used, BUF_SIZE - c->used);
+    }
+    if (n < 0) {
+        if (errno == EINTR) return 0;
+        perror("read");
+        return -1;
+    }
+    if (n == 0) {
+        // FIN de conexión
+        printf("Cliente cerró la conexión.\n");
+        return -1;
+    }
+
+    int used = c->used + (int)n;
+
+    // Procesar tantas PDUs completas como haya en el buffer
+    int processed = 0;
+    while (used - processed >= 9) {
+        // Buscamos delimitador '|' (0x7C) a partir del byte 8
+        int start = processed;
+        int min_index = start + 8; // timestamp ocupa 8 bytes
+        int found = -1;
+        for (int i = min_index; i < used; i++) {
+            if ((unsigned char)buf[i] == '|') {
+                found = i;
+                break;
+            }
+        }
+        if (found == -1) {
+            // No hay delimitador completo todavía
             break;
         }
-        if (n == 0) {
-            // FIN de conexión
-            printf("Cliente cerró la conexión.\n");
+
+        int pdu_len = found - start + 1; // desde start hasta incluido '|'
+        if (pdu_len < MIN_PDU_LEN || pdu_len > MAX_PDU_LEN) {
+            // PDU de tamaño inválido, la descartamos (en TP real podrías loguear)
+            fprintf(stderr, "PDU invalida (len=%d), descartando\n", pdu_len);
+            processed = found + 1;
+            continue;
+        }
+
+        // Tenemos una PDU completa en buf[start .. start+pdu_len-1]
+        handle_pdu(w, c, buf + start, pdu_len);
+        processed = start + pdu_len;
+    }
+
+    // Compactar buffer dejando sólo bytes no procesados
+    if (processed > 0) {
+        memmove(buf, buf + processed, used - processed);
+        used -= processed;
+    }
+
+    // Si el buffer se llena demasiado y no se encontró '|' algo raro pasa
+    if (used == BUF_SIZE) {
+        fprintf(stderr, "Buffer lleno sin encontrar delimitador; reseteando.\n");
+        used = 0;
+    }
+    c->used = used;
+    return 0;
+}
+
+static void print_summary(const probe_conn_t *c, const probe_opts_t *opts) {
+    const owd_hist_t *h = &c->h_all;
+
+    // Mismo formato de resumen que udp_server para comparar ambos transportes
+    if (c->measurement > 0) {
+        printf("RESUMEN tcp: n=%d owd_min_ms=%.3f owd_avg_ms=%.3f owd_max_ms=%.3f\n",
+               c->measurement, h->min_us / 1e3, hist_mean(h) / 1e3, h->max_us / 1e3);
+        // PDV contra el mínimo final: percentil(D) - min(D)
+        printf("RESUMEN tcp: jitter_rfc3550_ms=%.3f ipdv_abs_avg_ms=%.3f "
+               "ipdv_abs_p99_ms=%.3f pdv_p50_ms=%.3f pdv_p99_ms=%.3f pdv_p999_ms=%.3f\n",
+               c->pdv.jitter_us / 1e3, hist_mean(&c->pdv.ipdv_abs) / 1e3,
+               hist_percentile(&c->pdv.ipdv_abs, 99) / 1e3,
+               (hist_percentile(h, 50) - h->min_us) / 1e3,
+               (hist_percentile(h, 99) - h->min_us) / 1e3,
+               (hist_percentile(h, 99.9) - h->min_us) / 1e3);
+    }
+    if (c->sched_seen) {
+        printf("RESUMEN tcp (corregido por coordinated omission): ranuras_omitidas=%llu "
+               "p50_ms=%.3f p99_ms=%.3f p999_ms=%.3f max_ms=%.3f\n",
+               (unsigned long long)c->missed_total,
+               hist_percentile(&c->h_co, 50) / 1e3, hist_percentile(&c->h_co, 99) / 1e3,
+               hist_percentile(&c->h_co, 99.9) / 1e3, c->h_co.max_us / 1e3);
+        printf("RESUMEN tcp (sin corregir): "
+               "p50_ms=%.3f p99_ms=%.3f p999_ms=%.3f max_ms=%.3f\n",
+               hist_percentile(h, 50) / 1e3, hist_percentile(h, 99) / 1e3,
+               hist_percentile(h, 99.9) / 1e3, h->max_us / 1e3);
+    }
+    if (opts->rx_stamp && c->h_rx.count > 0) {
+        const owd_hist_t *r = &c->h_rx;
+        printf("RESUMEN recepción (%s): lecturas=%llu kernel_a_app_us p50=%.1f "
+               "p99=%.1f p999=%.1f max=%.1f\n", opts->busy ? "busy-poll" : "poll",
+               (unsigned long long)r->count, hist_percentile(r, 50) / 1e3,
+               hist_percentile(r, 99) / 1e3, hist_percentile(r, 99.9) / 1e3,
+               r->max_us / 1e3);
+    }
+    if (opts->load) {
+        print_load_report(&c->h_idle, &c->h_loaded);
+    }
+}
+
+// Matriz del barrido: una fila por fase, a stdout y a owd_matrix.csv
+static void print_matrix(phase_stats_t **phases, int phases_total) {
+    FILE *f = fopen("owd_matrix.csv", "w");
+    if (f) {
+        fprintf(f, "phase,delay_ms,payload_min,payload_max,conns,n,missed,avg_ms,"
+                   "p50_ms,p99_ms,p999_ms,max_ms,co_p99_ms,jitter_ms\n");
+    }
+    printf("Matriz del barrido (%d fases):\n", phases_total);
+    printf("  %5s %6s %9s %5s %8s %7s %9s %9s %9s %9s\n", "fase", "d_ms", "payload",
+           "conex", "n", "omit", "p50_ms", "p99_ms", "max_ms", "co_p99");
+    for (int i = 0; i < phases_total && i < MAX_PHASES; i++) {
+        phase_stats_t *ph = phases[i];
+        if (!ph) {
+            printf("  %5d (sin datos)\n", i);
+            continue;
+        }
+        const owd_hist_t *h = &ph->h;
+        double jitter = ph->seen_conns ? ph->jitter_sum_us / ph->seen_conns : 0.0;
+        char payload[24];
+        snprintf(payload, sizeof(payload), "%d-%d", ph->tag.payload_min, ph->tag.payload_max);
+        printf("  %5d %6d %9s %5d %8llu %7llu %9.3f %9.3f %9.3f %9.3f\n", i,
+               ph->tag.delay_ms, payload, ph->tag.conns, (unsigned long long)h->count,
+               (unsigned long long)ph->missed, hist_percentile(h, 50) / 1e3,
+               hist_percentile(h, 99) / 1e3, h->max_us / 1e3,
+               hist_percentile(&ph->h_co, 99) / 1e3);
+        if (f) {
+            fprintf(f, "%d,%d,%d,%d,%d,%llu,%llu,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n", i,
+                    ph->tag.delay_ms, ph->tag.payload_min, ph->tag.payload_max,
+                    ph->tag.conns, (unsigned long long)h->count,
+                    (unsigned long long)ph->missed, hist_mean(h) / 1e3,
+                    hist_percentile(h, 50) / 1e3, hist_percentile(h, 99) / 1e3,
+                    hist_percentile(h, 99.9) / 1e3, h->max_us / 1e3,
+                    hist_percentile(&ph->h_co, 99) / 1e3, jitter / 1e3);
+        }
+    }
+    if (f) fclose(f);
+}
+
+static void reset_phases(phase_stats_t **phases, int *phases_total) {
+    for (int i = 0; i < MAX_PHASES; i++) {
+        free(phases[i]);
+        phases[i] = NULL;
+    }
+    *phases_total = 0;
+}
+
+// Junta las tablas de fases de los n hilos y arma la matriz (con los hilos
+// bloqueados). Una fase puede tener conexiones repartidas en varios hilos.
+static void print_merged_matrix(int n) {
+    static phase_stats_t *merged[MAX_PHASES];
+    int total = 0;
+    for (int k = 0; k < n; k++) {
+        if (workers[k].phases_total > total) total = workers[k].phases_total;
+        for (int i = 0; i < MAX_PHASES; i++) {
+            const phase_stats_t *src = workers[k].phases[i];
+            if (!src) continue;
+            phase_stats_t *dst = merged[i];
+            if (!dst) {
+                if (!(dst = malloc(sizeof(*dst)))) continue;
+                *dst = *src;
+                merged[i] = dst;
+                continue;
+            }
+            dst->open_conns += src->open_conns;
+            dst->seen_conns += src->seen_conns;
+            dst->missed += src->missed;
+            dst->jitter_sum_us += src->jitter_sum_us;
+            hist_merge(&dst->h, &src->h);
+            hist_merge(&dst->h_co, &src->h_co);
+        }
+    }
+    print_matrix(merged, total);
+    reset_phases(merged, &total);
+}
+
+// 1 si hay un barrido en curso: falta alguna fase o quedan conexiones abiertas
+static int sweep_pending(int n) {
+    int total = 0;
+    for (int k = 0; k < n; k++) {
+        if (workers[k].phases_total > total) total = workers[k].phases_total;
+    }
+    for (int i = 0; i < total && i < MAX_PHASES; i++) {
+        int seen = 0;
+        for (int k = 0; k < n; k++) {
+            const phase_stats_t *ph = workers[k].phases[i];
+            if (!ph) continue;
+            if (ph->open_conns > 0) return 1;
+            seen = 1;
+        }
+        if (!seen) return 1;
+    }
+    return 0;
+}
+
+static void mptcp_sample(probe_conn_t *c, mptcp_snapshot_t *snap) {
+    mptcp_snapshot(c->fd, snap);
+    if (!mptcp_fp || snap->fallback) return;
+
+    uint64_t t = now_us();
+    unsigned long long n = atomic_load(&csv_rows);
+    pthread_mutex_lock(&mptcp_lock);
+    for (int i = 0; i < snap->n; i++) {
+        const mptcp_subflow_t *sf = &snap->sf[i];
+        fprintf(mptcp_fp, "%.6f,%d,%llu,%d,%s,%s,%.3f,%.3f,%u,%u,%llu,%llu\n",
+                (double)t / 1e6, c->id, n, i, sf->local, sf->remote, sf->rtt_us / 1e3,
+                sf->rttvar_us / 1e3, sf->cwnd, sf->retrans,
+                (unsigned long long)sf->bytes_sent, (unsigned long long)sf->bytes_received);
+    }
+    pthread_mutex_unlock(&mptcp_lock);
+}
+
+static void probe_conn_close(probe_worker_t *w, probe_conn_t *c) {
+    print_summary(c, w->opts);
+    if (w->opts->mptcp) {
+        mptcp_snapshot_t snap;
+        mptcp_sample(c, &snap);
+        mptcp_print(&snap, "tcp rx");
+    }
+    if (c->phase >= 0 && w->phases[c->phase]) {
+        phase_stats_t *ph = w->phases[c->phase];
+        ph->open_conns--;
+        ph->jitter_sum_us += c->pdv.jitter_us;
+    }
+    close(c->fd);
+    free(c);
+}
+
+// Opciones de socket de una conexión de sonda recién aceptada (modos -b y -q)
+static void setup_probe_socket(const probe_opts_t *opts, int fd) {
+    static atomic_int warned;   // se llama desde todos los hilos receptores
+    if (opts->busy && opts->busy_poll_us > 0) {
+        // subir SO_BUSY_POLL por encima de net.core.busy_read pide CAP_NET_ADMIN;
+        // sin él igual se gira sobre poll(0), sólo que sin sondear la NIC
+        int us = opts->busy_poll_us, one = 1;
+        if ((setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &us, sizeof(us)) < 0 ||
+             setsockopt(fd, SOL_SOCKET, SO_PREFER_BUSY_POLL, &one, sizeof(one)) < 0) &&
+            !atomic_exchange(&warned, 1)) {
+            perror("SO_BUSY_POLL/SO_PREFER_BUSY_POLL");
+        }
+    }
+    if (opts->rx_stamp) {
+        int flags = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+        if (setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) < 0) {
+            perror("SO_TIMESTAMPING");
+        }
+    }
+}
+
+static uint64_t thread_cpu_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000;
+}
+
+// Bucle de un hilo receptor: accept y read de sus conexiones, nada más
+static void *probe_worker_thread(void *arg) {
+    probe_worker_t *w = arg;
+    struct pollfd pfds[1 + MAX_PROBE_CONNS];
+    int slot_of[1 + MAX_PROBE_CONNS];
+    uint64_t wall0_us = now_us(), cpu0_us = thread_cpu_us();
+
+    if (w->opts->workers > 1 || w->opts->busy) {
+        // un hilo por core: el procesamiento de cada flujo no salta de CPU (y
+        // en modo -b el hilo que gira no compite con el resto)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(w->id % (int)sysconf(_SC_NPROCESSORS_ONLN), &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+
+    while (!atomic_load(&workers_stop)) {
+        int nfds = 0;
+        pfds[nfds++] = (struct pollfd){ w->active < MAX_PROBE_CONNS ? w->listenfd : -1,
+                                        POLLIN, 0 };
+        for (int i = 0; i < MAX_PROBE_CONNS; i++) {
+            if (!w->conns[i]) continue;
+            slot_of[nfds] = i;
+            pfds[nfds++] = (struct pollfd){ w->conns[i]->fd, POLLIN, 0 };
+        }
+
+        // timeout corto sólo para notar workers_stop; en modo -b no se duerme
+        // nunca: se gira sobre poll(0) y los datos se leen apenas llegan
+        int pr = poll(pfds, (nfds_t)nfds, w->opts->busy ? 0 : 200);
+        if (pr < 0) {
+            if (errno == EINTR) continue;
+            perror("poll");
             break;
         }
+        // las filas pendientes se escriben por lote lleno o, con poco
+        // tráfico, cada CSV_HOLD_US; no en cada vuelta, que toma csv_lock
+        if (w->rows_used > 0 && now_us() - w->flushed_us >= CSV_HOLD_US) flush_rows(w);
+        if (pr == 0) continue;
 
-        used += (int)n;
+        pthread_mutex_lock(&w->lock);
+        for (int k = 1; k < nfds; k++) {
+            if (pfds[k].revents == 0) continue;
+            int i = slot_of[k];
+            if (probe_conn_read(w, w->conns[i]) < 0) {
+                // sus filas al CSV antes de que el principal vea la conexión cerrada
+                flush_rows(w);
+                probe_conn_close(w, w->conns[i]);
+                w->conns[i] = NULL;
+                w->active--;
+            }
+        }
 
-        // Procesar tantas PDUs completas como haya en el buffer
-        int processed = 0;
-        while (used - processed >= 9) {
-            // Buscamos delimitador '|' (0x7C) a partir del byte 8
-            int start = processed;
-            int min_index = start + 8; // timestamp ocupa 8 bytes
-            int found = -1;
-            for (int i = min_index; i < used; i++) {
-                if ((unsigned char)buf[i] == '|') {
-                    found = i;
-                    break;
+        if (pfds[0].revents & POLLIN) {
+            int fd = accept(w->listenfd, NULL, NULL);
+            if (fd >= 0) {
+                int i = 0;
+                while (w->conns[i]) i++;
+                setup_probe_socket(w->opts, fd);
+                if (!(w->conns[i] = probe_conn_new(fd))) {
+                    close(fd);
+                } else if (w->opts->mptcp) {
+                    mptcp_snapshot_t snap;
+                    mptcp_snapshot(fd, &snap);
+                    printf("Cliente conectado (%s).\n", snap.fallback ? "TCP" : "MPTCP");
+                    w->active++;
+                    w->accepted++;
+                } else {
+                    printf("Cliente conectado.\n");
+                    w->active++;
+                    w->accepted++;
                 }
             }
-            if (found == -1) {
-                // No hay delimitador completo todavía
-                break;
+        }
+
+        if (w->opts->mptcp) {
+            // fotos periódicas de los subflujos (RTT, cwnd, retransmisiones)
+            uint64_t t = now_us();
+            uint64_t period_us = (uint64_t)(w->opts->interval_ms > 0 ? w->opts->interval_ms
+                                                                     : 1000) * 1000ULL;
+            for (int i = 0; i < MAX_PROBE_CONNS; i++) {
+                probe_conn_t *c = w->conns[i];
+                if (!c || t < c->mptcp_next_us) continue;
+                mptcp_snapshot_t snap;
+                mptcp_sample(c, &snap);
+                c->mptcp_next_us = t + period_us;
+            }
+        }
+        pthread_mutex_unlock(&w->lock);
+    }
+
+    pthread_mutex_lock(&w->lock);
+    for (int i = 0; i < MAX_PROBE_CONNS; i++) {
+        if (w->conns[i]) {
+            probe_conn_close(w, w->conns[i]);
+            w->conns[i] = NULL;
+        }
+    }
+    w->active = 0;
+    pthread_mutex_unlock(&w->lock);
+    flush_rows(w);
+
+    // Precio del modo -b: CPU del hilo receptor sobre el tiempo de la prueba
+    if (w->opts->busy || w->opts->rx_stamp) {
+        uint64_t wall = now_us() - wall0_us;
+        printf("Hilo receptor %d (%s): cpu=%.1f%% de un core\n", w->id,
+               w->opts->busy ? "busy-poll" : "poll",
+               wall ? 100.0 * (double)(thread_cpu_us() - cpu0_us) / (double)wall : 0.0);
+    }
+    return NULL;
+}
+
+static void publish_interval(int n, owd_interval_t *iv, uint64_t t0_us, uint64_t t,
+                             monitor_t *mon, int skip_empty) {
+    // Con varias conexiones se informa el jitter promedio entre ellas
+    double jitter = 0;
+    int conns = 0;
+    for (int k = 0; k < n; k++) {
+        probe_worker_t *w = &workers[k];
+        pthread_mutex_lock(&w->lock);
+        hist_merge(&iv->hist, &w->iv.hist);
+        iv->bytes += w->iv.bytes;
+        hist_init(&w->iv.hist);
+        w->iv.bytes = 0;
+        for (int i = 0; i < MAX_PROBE_CONNS; i++) {
+            if (w->conns[i]) {
+                jitter += w->conns[i]->pdv.jitter_us;
+                conns++;
             }
+        }
+        pthread_mutex_unlock(&w->lock);
+    }
+    if (skip_empty && iv->hist.count == 0) return;
+    char line[256];
+    int len = interval_flush(iv, t0_us, t, conns ? jitter / conns : 0.0, line, sizeof(line));
+    fputs(line, stdout);
+    fflush(stdout);
+    monitor_publish(mon, line, len);
+}
+
+static void lock_workers(int n) {
+    for (int k = 0; k < n; k++) pthread_mutex_lock(&workers[k].lock);
+}
+
+static void unlock_workers(int n) {
+    for (int k = 0; k < n; k++) pthread_mutex_unlock(&workers[k].lock);
+}
 
-            int pdu_len = found - start + 1; // desde start hasta incluido '|'
-            if (pdu_len < 509 || pdu_len > 1009) {
-                // PDU de tamaño inválido, la descartamos (en TP real podrías loguear)
-                fprintf(stderr, "PDU invalida (len=%d), descartando\n", pdu_len);
-                processed = found + 1;
+// Atiende conexiones de sonda (varias a la vez, repartidas entre los n hilos
+// receptores) hasta que no quede ninguna (o hasta una señal, en modo continuo).
+// Este hilo sólo reporta: agregados en vivo, monitor, flush del CSV y matriz.
+static void serve_probes(int n, const probe_opts_t *opts, csv_log_t *csv, monitor_t *mon) {
+    // Agregados por intervalo: se emiten aunque no lleguen PDUs (conexión
+    // trabada), por eso se espera con poll() y timeout. El mismo timeout
+    // acota la espera del flush periódico del CSV.
+    uint64_t t0_us = now_us();
+    static owd_interval_t iv;
+    interval_init(&iv, t0_us, opts->interval_ms);
+
+    // Los hilos receptores no atienden señales: llegan a este hilo
+    sigset_t block, old;
+    sigemptyset(&block);
+    sigaddset(&block, SIGINT);
+    sigaddset(&block, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &block, &old);
+    for (int k = 0; k < n; k++) {
+        interval_init(&workers[k].iv, t0_us, opts->interval_ms);
+        pthread_create(&workers[k].thread, NULL, probe_worker_thread, &workers[k]);
+    }
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+    while (!stop_requested) {
+        pthread_mutex_lock(&csv_lock);
+        csv_log_tick(csv);
+        pthread_mutex_unlock(&csv_lock);
+
+        // además se revisa seguido si terminaron los clientes
+        int timeout_ms = csv->flush_ms > 0 && csv->flush_ms < 200 ? csv->flush_ms : 200;
+        if (opts->interval_ms > 0) {
+            uint64_t t = now_us();
+            if (t - iv.start_us >= iv.interval_us) {
+                int active = 0;
+                for (int k = 0; k < n; k++) active += workers[k].active;
+                if (active > 0) publish_interval(n, &iv, t0_us, t, mon, 0);
+                else iv.start_us = t;     // sin clientes no hay nada que reportar
                 continue;
             }
+            int left_ms = (int)((iv.start_us + iv.interval_us - t + 999) / 1000);
+            if (left_ms < timeout_ms) timeout_ms = left_ms;
+        }
+
+        struct pollfd pfd = { mon->listenfd, POLLIN, 0 };
+        int pr = poll(&pfd, 1, timeout_ms);
+        if (stop_requested) break;
+        if (pr < 0) {
+            if (errno == EINTR) continue;
+            perror("poll");
+            break;
+        }
+        if (pfd.revents & POLLIN) {
+            monitor_accept(mon);
+        }
+
+        // Foto consistente de todos los hilos
+        lock_workers(n);
+        int active = 0, accepted = 0;
+        for (int k = 0; k < n; k++) {
+            active += workers[k].active;
+            accepted += workers[k].accepted;
+        }
+        int done = active == 0 && accepted > 0 && !sweep_pending(n);
+        if (done) {
+            int sweep = 0;
+            for (int k = 0; k < n; k++) sweep |= workers[k].phases_total > 0;
+            if (sweep) {
+                print_merged_matrix(n);
+                for (int k = 0; k < n; k++) {
+                    reset_phases(workers[k].phases, &workers[k].phases_total);
+                }
+            }
+            for (int k = 0; k < n; k++) workers[k].accepted = 0;
+        }
+        unlock_workers(n);
 
-            // Tenemos una PDU completa en buf[start .. start+pdu_len-1]
-            uint64_t origin_ts_us = 0;
-            memcpy(&origin_ts_us, buf + start, sizeof(uint64_t));
+        if (done) {
+            // Último cliente (o última fase del barrido) terminado
+            if (opts->interval_ms > 0) {
+                publish_interval(n, &iv, t0_us, now_us(), mon, 1);
+            }
+            fflush(stdout);
+            pthread_mutex_lock(&csv_lock);
+            if (csv->fp) fflush(csv->fp);
+            pthread_mutex_unlock(&csv_lock);
+            if (!opts->continuous) break;
+        }
+    }
+
+    atomic_store(&workers_stop, 1);
+    for (int k = 0; k < n; k++) pthread_join(workers[k].thread, NULL);
+
+    int sweep = 0;
+    for (int k = 0; k < n; k++) sweep |= workers[k].phases_total > 0;
+    if (sweep) print_merged_matrix(n);
+}
+
+int main(int argc, char *argv[]) {
+    int listenfd, connfd;
+    struct sockaddr_in cli_addr;
+    socklen_t cli_len = sizeof(cli_addr);
+    int bulk = 0, use_splice = 0;
+    int monitor_port = 0;
+    int sync_clients = 0, sync_lead_ms = 1000;
+    monitor_t mon;
+    probe_opts_t opts = { BULK_INTERVAL_MS, 0, 0, 1, 0, 0, 0, 0 };
+    csv_log_t csv = { .base = "owd_results", .flush_ms = 1000 };
+    monitor_init(&mon);   // sin -m (o si falla) publish y close no tocan nada
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-B") == 0) {
+            bulk = 1;
+        } else if (strcmp(argv[i], "-s") == 0) {
+            use_splice = 1;
+        } else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+            opts.interval_ms = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-L") == 0) {
+            opts.load = 1;
+        } else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+            monitor_port = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-C") == 0) {
+            opts.continuous = 1;
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            csv.max_bytes = strtoull(argv[++i], NULL, 10) * 1024ULL * 1024ULL;
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            csv.max_age_us = strtoull(argv[++i], NULL, 10) * 1000000ULL;
+        } else if (strcmp(argv[i], "-k") == 0 && i + 1 < argc) {
+            csv.keep = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+            csv.flush_ms = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+            sync_clients = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-W") == 0 && i + 1 < argc) {
+            sync_lead_ms = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            opts.workers = atoi(argv[++i]);
+            if (opts.workers == 0) opts.workers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+        } else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            opts.busy = 1;
+            opts.busy_poll_us = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-q") == 0) {
+            opts.rx_stamp = 1;
+        } else if (strcmp(argv[i], "-M") == 0) {
+            opts.mptcp = 1;
+        } else {
+            fprintf(stderr,
+                    "Uso: %s [-L] [-i intervalo_ms] [-m puerto] [-C] [-r MB] [-t seg]\n"
+                    "          [-k segmentos] [-f flush_ms] [-w clientes [-W margen_ms]] [-j hilos]\n"
+                    "          [-b us] [-q] [-M] [-B [-s]]\n"
+                    "  -i  período de los agregados en vivo (0 = sin agregados)\n"
+                    "  -m  publicar además los agregados en 127.0.0.1:<puerto>\n"
+                    "  -C  operación continua: sigue aceptando clientes al terminar\n"
+                    "  -r  rotar el CSV al superar <MB>; -t rotar cada <seg> segundos\n"
+                    "      (segmentos owd_results-*.csv, comprimidos con gzip al cerrarse)\n"
+                    "  -k  conservar sólo los últimos <segmentos> comprimidos\n"
+                    "  -f  período de flush del CSV (por defecto 1000 ms)\n"
+                    "  -w  esperar a que se registren <clientes> (tcp_client -w) en el\n"
+                    "      puerto %d y darles a todos el mismo instante de inicio,\n"
+                    "      <margen_ms> en el futuro (-W, por defecto 1000)\n"
+                    "  -j  hilos receptores, cada uno con su listener SO_REUSEPORT y fijo\n"
+                    "      a un core (0 = uno por core; por defecto 1)\n"
+                    "  -b  busy-poll: los hilos receptores giran sin dormir (fijos a un\n"
+                    "      core) y cada conexión usa SO_BUSY_POLL=<us> y\n"
+                    "      SO_PREFER_BUSY_POLL (0 = sólo girar)\n"
+                    "  -q  medir la demora kernel -> aplicación de cada lectura\n"
+                    "      (SO_TIMESTAMPING) y el CPU de los hilos, para comparar -b\n"
+                    "  -M  aceptar MPTCP (y TCP común) y registrar RTT, cwnd y\n"
+                    "      retransmisiones de cada subflujo en owd_mptcp.csv\n"
+                    "  -B  modo throughput: sumidero de un flujo masivo en el puerto %d\n"
+                    "  -s  descartar con splice() a /dev/null en vez de read()\n"
+                    "  -L  latencia bajo carga: acepta además flujos masivos en el\n"
+                    "      puerto %d y compara la OWD en reposo vs. con carga\n",
+                    argv[0], CTRL_PORT, BULK_PORT, BULK_PORT);
+            return EXIT_FAILURE;
+        }
+    }
+    int port = bulk ? BULK_PORT : SERVER_PORT;
+    if (opts.workers < 1 || opts.workers > MAX_WORKERS) {
+        fprintf(stderr, "Cantidad de hilos inválida (1-%d)\n", MAX_WORKERS);
+        return EXIT_FAILURE;
+    }
 
-            uint64_t dest_ts_us = now_us();
-            double delay_s = (double)(dest_ts_us - origin_ts_us) / 1e6;
+    // 1) Crear socket TCP
+    // backlog holgado: con -w todos los clientes conectan a la vez
+    if ((listenfd = listen_on(port, 64, !bulk && opts.workers > 1, opts.mptcp)) < 0) {
+        exit(EXIT_FAILURE);
+    }
 
-            measurement++;
-            fprintf(csv, "%d,%.6f\n", measurement, delay_s);
+    printf("Servidor TCP escuchando en puerto %d...\n", port);
 
-            processed = start + pdu_len;
+    if (opts.load && !bulk) {
+        int bulkfd = listen_on(BULK_PORT, 16, 0, opts.mptcp);
+        pthread_t t;
+        if (bulkfd < 0 ||
+            pthread_create(&t, NULL, bulk_accept_thread, (void *)(intptr_t)bulkfd) != 0) {
+            fprintf(stderr, "No se pudo iniciar el receptor de carga\n");
+            close(listenfd);
+            exit(EXIT_FAILURE);
         }
+        pthread_detach(t);
+        printf("Flujos de carga en puerto %d.\n", BULK_PORT);
+    }
+
+    if (!bulk && monitor_port > 0 && monitor_open(&mon, monitor_port) == 0) {
+        printf("Agregados en vivo en 127.0.0.1:%d\n", monitor_port);
+    }
+
+    // Sin SA_RESTART: accept() y poll() vuelven con EINTR
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_stop_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    if (bulk) {
+        int ret = EXIT_SUCCESS;
+        do {
+            cli_len = sizeof(cli_addr);
+            connfd = accept(listenfd, (struct sockaddr*)&cli_addr, &cli_len);
+            if (stop_requested) break;
+            if (connfd < 0) {
+                if (opts.continuous && errno == EINTR) continue;
+                perror("accept");
+                ret = EXIT_FAILURE;
+                break;
+            }
+            printf("Cliente conectado.\n");
+            if (bulk_sink(connfd, use_splice, opts.interval_ms, "bulk rx") < 0) {
+                ret = EXIT_FAILURE;
+            }
+            close(connfd);
+        } while (opts.continuous && !stop_requested);
+        close(listenfd);
+        return ret;
+    }
 
-        // Compactar buffer dejando sólo bytes no procesados
-        if (processed > 0) {
-            memmove(buf, buf + processed, used - processed);
-            used -= processed;
+    // podés dejar sin header si querés
+    csv.header = opts.load
+        ? "n,delay_s,ipdv_s,pdv_s,jitter_s,sched_delay_s,missed,phase,bulk_flows\n"
+        : "n,delay_s,ipdv_s,pdv_s,jitter_s,sched_delay_s,missed,phase\n";
+    if (csv_log_open(&csv) < 0) {
+        close(listenfd);
+        exit(EXIT_FAILURE);
+    }
+    csv_out = &csv;
+
+    if (opts.mptcp) {
+        mptcp_fp = fopen("owd_mptcp.csv", "w");
+        if (!mptcp_fp) {
+            perror("fopen owd_mptcp.csv");
+        } else {
+            fprintf(mptcp_fp, "t_s,conn,n,subflow,local,remote,rtt_ms,rttvar_ms,cwnd,"
+                              "retrans,bytes_tx,bytes_rx\n");
         }
+    }
 
-        // Si el buffer se llena demasiado y no se encontró '|' algo raro pasa
-        if (used == BUF_SIZE) {
-            fprintf(stderr, "Buffer lleno sin encontrar delimitador; reseteando.\n");
-            used = 0;
+    // Un listener por hilo receptor (el primero es listenfd)
+    for (int k = 0; k < opts.workers; k++) {
+        probe_worker_t *w = &workers[k];
+        w->id = k;
+        w->opts = &opts;
+        w->listenfd = k == 0 ? listenfd : listen_on(port, 64, 1, opts.mptcp);
+        pthread_mutex_init(&w->lock, NULL);
+        if (w->listenfd < 0) {
+            csv_log_close(&csv);
+            exit(EXIT_FAILURE);
         }
     }
+    if (opts.workers > 1) {
+        printf("%d hilos receptores (SO_REUSEPORT).\n", opts.workers);
+    }
+
+    // Las conexiones de sonda que lleguen mientras tanto esperan en el backlog
+    if (sync_clients > 0 &&
+        ctrl_start_clients(CTRL_PORT, sync_clients, sync_lead_ms, &stop_requested) < 0) {
+        fprintf(stderr, "No se pudo sincronizar el inicio de los clientes\n");
+        csv_log_close(&csv);
+        close(listenfd);
+        exit(EXIT_FAILURE);
+    }
+
+    serve_probes(opts.workers, &opts, &csv, &mon);
 
-    fclose(csv);
-    close(connfd);
-    close(listenfd);
+    monitor_close(&mon);
+    csv_log_close(&csv);
+    if (mptcp_fp) fclose(mptcp_fp);
+    for (int k = 0; k < opts.workers; k++) close(workers[k].listenfd);
     return 0;
 }
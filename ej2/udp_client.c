@@ -0,0 +1,137 @@
+// udp_client.c
+// Variante UDP de tcp_client: mismo timestamp + número de secuencia, para
+// distinguir pérdida y reordenamiento del retardo (TCP los oculta como latencia).
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/time.h>
+#include "probe.h"
+
+int main(int argc, char *argv[]) {
+    if (argc < 5) {
+        fprintf(stderr,
+                "Uso: %s <IP Servidor> -d <delay_ms> -N <duracion_s> [-T]\n"
+                "  -T  enviar además cada sonda por TCP a tcp_server (mismo timestamp)\n",
+                argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const char *server_ip = argv[1];
+    int delay_ms = -1;
+    int duration_s = -1;
+    int also_tcp = 0;
+
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+            delay_ms = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-N") == 0 && i + 1 < argc) {
+            duration_s = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-T") == 0) {
+            also_tcp = 1;
+        }
+    }
+
+    if (delay_ms <= 0 || duration_s <= 0) {
+        fprintf(stderr,
+                "Parámetros inválidos. Ejemplo: %s 192.168.20.144 -d 50 -N 10\n",
+                argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    int udpfd, tcpfd = -1;
+    struct sockaddr_in serv_addr;
+
+    memset(&serv_addr, 0, sizeof(serv_addr));
+    serv_addr.sin_family = AF_INET;
+    serv_addr.sin_port   = htons(UDP_PROBE_PORT);
+    if (inet_pton(AF_INET, server_ip, &serv_addr.sin_addr) <= 0) {
+        perror("inet_pton");
+        return EXIT_FAILURE;
+    }
+
+    if ((udpfd = socket(AF_INET, SOCK_DGRAM, 0)) < 0) {
+        perror("socket");
+        return EXIT_FAILURE;
+    }
+    // connect() en UDP fija el destino y permite usar send()
+    if (connect(udpfd, (struct sockaddr *)&serv_addr, sizeof(serv_addr)) < 0) {
+        perror("connect udp");
+        close(udpfd);
+        return EXIT_FAILURE;
+    }
+
+    if (also_tcp) {
+        struct sockaddr_in tcp_addr = serv_addr;
+        tcp_addr.sin_port = htons(SERVER_PORT);
+        if ((tcpfd = socket(AF_INET, SOCK_STREAM, 0)) < 0 ||
+            connect(tcpfd, (struct sockaddr *)&tcp_addr, sizeof(tcp_addr)) < 0) {
+            perror("connect tcp");
+            if (tcpfd >= 0) close(tcpfd);
+            close(udpfd);
+            return EXIT_FAILURE;
+        }
+    }
+
+    printf("Enviando sondas UDP a %s:%d%s. delay=%d ms, duracion=%d s\n",
+           server_ip, UDP_PROBE_PORT, also_tcp ? " (+TCP)" : "",
+           delay_ms, duration_s);
+
+    uint64_t start_us = now_us();
+    uint64_t duration_us = (uint64_t)duration_s * 1000000ULL;
+
+    char dgram[UDP_MAX_PDU_LEN];
+    char pdu[MAX_PDU_LEN];
+    uint32_t seq = 0;
+
+    srand((unsigned int)start_us);
+
+    while (1) {
+        uint64_t t_now = now_us();
+        if (t_now - start_us >= duration_us) {
+            break;
+        }
+
+        uint64_t origin_ts_us = t_now;
+        int payload_len = MIN_PAYLOAD_SIZE +
+            rand() % (MAX_PAYLOAD_SIZE - MIN_PAYLOAD_SIZE + 1);
+
+        // armar PDU: 8 bytes timestamp + 4 bytes seq + payload + '|'
+        memcpy(dgram, &origin_ts_us, TS_LEN);
+        memcpy(dgram + TS_LEN, &seq, SEQ_LEN);
+        memset(dgram + UDP_HDR_LEN, 0x20, payload_len);
+        dgram[UDP_HDR_LEN + payload_len] = PDU_DELIM;
+
+        if (send(udpfd, dgram, UDP_HDR_LEN + (size_t)payload_len + 1, 0) < 0) {
+            perror("send udp"); // en UDP un error puntual no corta la prueba
+        }
+        seq++;
+
+        if (tcpfd >= 0) {
+            size_t pdu_len = build_tcp_pdu(pdu, origin_ts_us, payload_len);
+            if (send_all(tcpfd, pdu, pdu_len) < 0) {
+                perror("send_all");
+                break;
+            }
+        }
+
+        usleep((unsigned int)delay_ms * 1000U);
+    }
+
+    // Marca de fin: se repite porque también puede perderse
+    uint64_t end_ts = now_us();
+    uint32_t end_seq = UDP_SEQ_END;
+    memcpy(dgram, &end_ts, TS_LEN);
+    memcpy(dgram + TS_LEN, &end_seq, SEQ_LEN);
+    for (int i = 0; i < 3; i++) {
+        send(udpfd, dgram, UDP_HDR_LEN, 0);
+    }
+
+    printf("Sondas enviadas: %u\n", seq);
+
+    if (tcpfd >= 0) close(tcpfd);
+    close(udpfd);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,187 @@
+// udp_server.c
+// Receptor de sondas UDP: OWD por PDU más pérdida y reordenamiento a partir
+// del número de secuencia.
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <arpa/inet.h>
+#include <sys/time.h>
+#include "probe.h"
+
+#define IDLE_TIMEOUT_S 5   // sin datagramas por este tiempo => fin de prueba
+// Una seq más allá de esto por encima de la mayor vista se descarta: un
+// datagrama roto no puede hacer crecer el mapa sin límite
+#define SEQ_WINDOW     (1u << 20)
+#define SEQ_MAP_MAX    (1u << 28)   // tope absoluto del mapa (32 MB)
+
+// Bitmap de secuencias recibidas (crece a demanda) para detectar duplicados
+typedef struct {
+    uint8_t *bits;
+    uint32_t cap;          // capacidad en secuencias
+} seq_map_t;
+
+// Devuelve 1 si seq ya estaba marcada, 0 si es nueva, -1 sin memoria o
+// fuera del tope del mapa
+static int seq_map_test_and_set(seq_map_t *m, uint32_t seq) {
+    if (seq >= m->cap) {
+        if (seq >= SEQ_MAP_MAX) return -1;
+        uint64_t ncap = m->cap ? m->cap : 8192;
+        while (ncap <= seq) ncap *= 2;
+        if (ncap > SEQ_MAP_MAX) ncap = SEQ_MAP_MAX;
+        uint8_t *nb = realloc(m->bits, (size_t)(ncap / 8));
+        if (!nb) return -1;
+        memset(nb + m->cap / 8, 0, (ncap - m->cap) / 8);
+        m->bits = nb;
+        m->cap = (uint32_t)ncap;
+    }
+    uint8_t mask = (uint8_t)(1u << (seq % 8));
+    if (m->bits[seq / 8] & mask) return 1;
+    m->bits[seq / 8] |= mask;
+    return 0;
+}
+
+int main(void) {
+    int sockfd;
+    struct sockaddr_in serv_addr, cli_addr;
+    socklen_t cli_len;
+
+    if ((sockfd = socket(AF_INET, SOCK_DGRAM, 0)) < 0) {
+        perror("socket");
+        exit(EXIT_FAILURE);
+    }
+
+    memset(&serv_addr, 0, sizeof(serv_addr));
+    serv_addr.sin_family      = AF_INET;
+    serv_addr.sin_addr.s_addr = INADDR_ANY;
+    serv_addr.sin_port        = htons(UDP_PROBE_PORT);
+
+    if (bind(sockfd, (struct sockaddr*)&serv_addr, sizeof(serv_addr)) < 0) {
+        perror("bind");
+        close(sockfd);
+        exit(EXIT_FAILURE);
+    }
+
+    printf("Servidor UDP de sondas escuchando en puerto %d...\n", UDP_PROBE_PORT);
+
+    FILE *csv = fopen("udp_owd_results.csv", "w");
+    if (!csv) {
+        perror("fopen csv");
+        close(sockfd);
+        exit(EXIT_FAILURE);
+    }
+    fprintf(csv, "n,seq,delay_s,reorder_dist\n");
+
+    char buf[UDP_MAX_PDU_LEN + 1];
+    seq_map_t seen = {0};
+    int measurement = 0;
+    int started = 0;
+    uint32_t max_seq = 0;
+    uint64_t duplicates = 0, reordered = 0, reorder_dist_sum = 0, out_of_window = 0;
+    uint32_t reorder_dist_max = 0;
+    double delay_min = 0, delay_max = 0, delay_sum = 0;
+
+    while (1) {
+        cli_len = sizeof(cli_addr);
+        ssize_t n = recvfrom(sockfd, buf, sizeof(buf), 0,
+                             (struct sockaddr*)&cli_addr, &cli_len);
+        uint64_t dest_ts_us = now_us();
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                printf("Sin datagramas por %d s, fin de la prueba.\n", IDLE_TIMEOUT_S);
+                break;
+            }
+            if (errno == EINTR) continue;
+            perror("recvfrom");
+            break;
+        }
+        if (n < UDP_HDR_LEN) continue;
+
+        uint64_t origin_ts_us;
+        uint32_t seq;
+        memcpy(&origin_ts_us, buf, TS_LEN);
+        memcpy(&seq, buf + TS_LEN, SEQ_LEN);
+
+        if (seq == UDP_SEQ_END) {
+            if (started) {
+                printf("Cliente indicó fin de la prueba.\n");
+                break;
+            }
+            continue;
+        }
+        if (n < UDP_MIN_PDU_LEN || n > UDP_MAX_PDU_LEN || buf[n - 1] != PDU_DELIM) {
+            fprintf(stderr, "PDU invalida (len=%zd), descartando\n", n);
+            continue;
+        }
+
+        if (!started) {
+            // A partir del primer datagrama el silencio prolongado cierra la prueba
+            struct timeval tv = { IDLE_TIMEOUT_S, 0 };
+            setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+            started = 1;
+        }
+
+        if ((uint64_t)seq > (uint64_t)max_seq + SEQ_WINDOW) {
+            out_of_window++;
+            continue;
+        }
+        int dup = seq_map_test_and_set(&seen, seq);
+        if (dup < 0) {
+            fprintf(stderr, "Sin memoria para el mapa de secuencias (seq=%u)\n", seq);
+            out_of_window++;
+            continue;
+        }
+        if (dup) {
+            duplicates++;
+            continue;
+        }
+
+        // Distancia de reordenamiento: cuánto "atrás" del máximo visto llega
+        uint32_t reorder_dist = 0;
+        if (measurement > 0 && seq < max_seq) {
+            reorder_dist = max_seq - seq;
+            reordered++;
+            reorder_dist_sum += reorder_dist;
+            if (reorder_dist > reorder_dist_max) reorder_dist_max = reorder_dist;
+        } else {
+            max_seq = seq;
+        }
+
+        double delay_s = (double)(int64_t)(dest_ts_us - origin_ts_us) / 1e6;
+
+        measurement++;
+        fprintf(csv, "%d,%u,%.6f,%u\n", measurement, seq, delay_s, reorder_dist);
+
+        if (measurement == 1 || delay_s < delay_min) delay_min = delay_s;
+        if (measurement == 1 || delay_s > delay_max) delay_max = delay_s;
+        delay_sum += delay_s;
+    }
+
+    if (measurement > 0) {
+        // Las sondas perdidas después de la última recibida no se pueden
+        // distinguir del fin de la prueba; se cuentan sólo los huecos.
+        uint64_t expected = (uint64_t)max_seq + 1;
+        uint64_t lost = expected - (uint64_t)measurement;
+        printf("RESUMEN udp: n=%d owd_min_ms=%.3f owd_avg_ms=%.3f owd_max_ms=%.3f\n",
+               measurement, delay_min * 1e3, delay_sum / measurement * 1e3,
+               delay_max * 1e3);
+        printf("RESUMEN udp: esperadas=%llu perdidas=%llu loss=%.3f%% "
+               "reordenadas=%llu dist_media=%.2f dist_max=%u duplicadas=%llu\n",
+               (unsigned long long)expected, (unsigned long long)lost,
+               100.0 * (double)lost / (double)expected,
+               (unsigned long long)reordered,
+               reordered ? (double)reorder_dist_sum / (double)reordered : 0.0,
+               reorder_dist_max, (unsigned long long)duplicates);
+    }
+    if (out_of_window > 0) {
+        printf("RESUMEN udp: %llu datagramas con seq fuera de ventana descartados\n",
+               (unsigned long long)out_of_window);
+    }
+
+    free(seen.bits);
+    fclose(csv);
+    close(sockfd);
+    return 0;
+}